@@ -0,0 +1,395 @@
+﻿//
+// asyncenumerator.h
+//
+// Copyright (c) 2024 Izadori
+//
+// This software is released under the MIT License.
+// http://opensource.org/licenses/mit-license.php
+//
+
+#ifndef __IZADORI_ASYNCENUMERATOR_H__
+#define __IZADORI_ASYNCENUMERATOR_H__
+
+#include "enumerator.h"
+
+#if defined(__cpp_impl_coroutine)
+
+#include <atomic>
+#include <condition_variable>
+#include <coroutine>
+#include <exception>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <type_traits>
+#include <utility>
+
+//-----------------------------------------------------------------------------------------
+// 非同期にまとまりを読み出すソースのためのenumerator()関数の実装（C++20対応のコンパイラが必要）
+//   auto items = AsyncEnumerate(source);
+//   while(auto batch = co_await items.Next())
+//   {
+//       for(auto [i, value] : *batch) { ... }
+//   }
+//-----------------------------------------------------------------------------------------
+
+template <typename T>
+class Task;
+
+//-----------------------------------------------------------------------------------------
+// TaskPromiseクラス - Task<>のpromise_type（戻り値の有無で特殊化する）
+//   stateは、0: 実行中、1: 完了を待っているコルーチンがある、2: 完了、3: Task<>が破棄された
+//-----------------------------------------------------------------------------------------
+template <typename T>
+struct TaskPromiseBase
+{
+	std::coroutine_handle<> continuation;
+	std::exception_ptr exception;
+	std::atomic<int> state{0};
+
+	struct FinalAwaiter
+	{
+		bool await_ready() noexcept
+		{
+			return false;
+		}
+
+		template <typename Promise>
+		std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept
+		{
+			int state = handle.promise().state.exchange(2, std::memory_order_acq_rel);
+
+			if(state == 1)
+			{
+				return handle.promise().continuation;
+			}
+			else if(state == 3)
+			{
+				handle.destroy();
+			}
+
+			return std::noop_coroutine();
+		}
+
+		void await_resume() noexcept {}
+	};
+
+	std::suspend_always initial_suspend() noexcept
+	{
+		return {};
+	}
+
+	FinalAwaiter final_suspend() noexcept
+	{
+		return {};
+	}
+
+	void unhandled_exception()
+	{
+		exception = std::current_exception();
+	}
+};
+
+template <typename T>
+struct TaskPromise : TaskPromiseBase<T>
+{
+	std::optional<T> value;
+
+	Task<T> get_return_object();
+
+	template <typename U>
+	void return_value(U && result)
+	{
+		value.emplace(std::forward<U>(result));
+	}
+
+	T GetResult()
+	{
+		if(this->exception)
+		{
+			std::rethrow_exception(this->exception);
+		}
+
+		return std::move(*value);
+	}
+};
+
+template <>
+struct TaskPromise<void> : TaskPromiseBase<void>
+{
+	Task<void> get_return_object();
+
+	void return_void() {}
+
+	void GetResult()
+	{
+		if(this->exception)
+		{
+			std::rethrow_exception(this->exception);
+		}
+	}
+};
+
+//-----------------------------------------------------------------------------------------
+// Taskクラス - co_awaitされた時に実行を始めるコルーチン
+//   Start()で先に実行を始めておき、後からco_awaitで結果を受け取ることもできる
+//   （他のスレッドで完了した場合は、そのスレッドで待っているコルーチンを再開する）
+//-----------------------------------------------------------------------------------------
+template <typename T = void>
+class Task final
+{
+public:
+	using promise_type = TaskPromise<T>;
+	using value_type = T;
+
+	Task(Task && task) noexcept : handle_(std::exchange(task.handle_, nullptr)), started_(task.started_) {}
+
+	Task & operator=(Task && task) noexcept
+	{
+		if(this != &task)
+		{
+			Release();
+			handle_ = std::exchange(task.handle_, nullptr);
+			started_ = task.started_;
+		}
+
+		return *this;
+	}
+
+	Task(const Task &) = delete;
+	Task & operator=(const Task &) = delete;
+
+	~Task()
+	{
+		Release();
+	}
+
+	// 最初に中断するまで、呼び出したスレッドで実行する
+	void Start()
+	{
+		if(!started_)
+		{
+			started_ = true;
+			handle_.resume();
+		}
+	}
+
+	bool await_ready() const
+	{
+		return started_ && handle_.promise().state.load(std::memory_order_acquire) == 2;
+	}
+
+	std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting)
+	{
+		handle_.promise().continuation = awaiting;
+
+		if(!started_)
+		{
+			started_ = true;
+			handle_.promise().state.store(1, std::memory_order_release);
+			return handle_;
+		}
+
+		// 待ち始める前に完了していた場合は、stateを2のままにして（Release()で破棄できるように）そのまま再開する
+		int running = 0;
+
+		if(!handle_.promise().state.compare_exchange_strong(running, 1, std::memory_order_acq_rel, std::memory_order_acquire))
+		{
+			return awaiting;
+		}
+
+		return std::noop_coroutine();
+	}
+
+	T await_resume()
+	{
+		return handle_.promise().GetResult();
+	}
+
+private:
+	std::coroutine_handle<promise_type> handle_;
+	bool started_;
+
+	explicit Task(std::coroutine_handle<promise_type> handle) : handle_(handle), started_(false) {}
+
+	// 実行中に破棄された場合は、完了した時にコルーチン自身が破棄する
+	void Release()
+	{
+		if(handle_)
+		{
+			if(!started_ || handle_.promise().state.exchange(3, std::memory_order_acq_rel) == 2)
+			{
+				handle_.destroy();
+			}
+
+			handle_ = nullptr;
+		}
+	}
+
+	friend promise_type;
+};
+
+template <typename T>
+Task<T> TaskPromise<T>::get_return_object()
+{
+	return Task<T>(std::coroutine_handle<TaskPromise<T>>::from_promise(*this));
+}
+
+inline Task<void> TaskPromise<void>::get_return_object()
+{
+	return Task<void>(std::coroutine_handle<TaskPromise<void>>::from_promise(*this));
+}
+
+//-----------------------------------------------------------------------------------------
+// SyncWait関数 - コルーチンではない関数から、taskが完了するまで待って結果を返す
+//-----------------------------------------------------------------------------------------
+template <typename T>
+T SyncWait(Task<T> task)
+{
+	struct Detached
+	{
+		struct promise_type
+		{
+			Detached get_return_object()
+			{
+				return {};
+			}
+
+			std::suspend_never initial_suspend() noexcept
+			{
+				return {};
+			}
+
+			std::suspend_never final_suspend() noexcept
+			{
+				return {};
+			}
+
+			void return_void() {}
+
+			void unhandled_exception()
+			{
+				std::terminate();
+			}
+		};
+	};
+
+	std::mutex mutex;
+	std::condition_variable cv;
+	bool done = false;
+	std::exception_ptr exception;
+	std::conditional_t<std::is_void_v<T>, bool, std::optional<T>> result{};
+
+	auto waiter = [&](Task<T> & task) -> Detached {
+		try
+		{
+			if constexpr(std::is_void_v<T>)
+			{
+				co_await task;
+			}
+			else
+			{
+				result.emplace(co_await task);
+			}
+		}
+		catch(...)
+		{
+			exception = std::current_exception();
+		}
+
+		std::lock_guard<std::mutex> lock(mutex);
+		done = true;
+		cv.notify_all();
+	};
+
+	waiter(task);
+
+	std::unique_lock<std::mutex> lock(mutex);
+	cv.wait(lock, [&done]() { return done; });
+
+	if(exception)
+	{
+		std::rethrow_exception(exception);
+	}
+
+	if constexpr(!std::is_void_v<T>)
+	{
+		return std::move(*result);
+	}
+}
+
+//-----------------------------------------------------------------------------------------
+// std::span<>はビューとしてEnumerator<>に値で保持する
+//-----------------------------------------------------------------------------------------
+template <typename T, size_t Extent>
+struct IsView<std::span<T, Extent>> : std::true_type {};
+
+//-----------------------------------------------------------------------------------------
+// AsyncEnumeratorクラス - 非同期に読み出したまとまりを、通し番号つきで順に返す
+//   sourceのNext()はTask<std::span<T>>を返し、空のspanで終端を表す
+//   現在のまとまりを処理している間に次のまとまりを先読みするため、sourceは直前に返した
+//   まとまりを次のNext()が完了した後も保持する（2つ以上のバッファを交互に使う）必要がある
+//-----------------------------------------------------------------------------------------
+template <class Source>
+class AsyncEnumerator final
+{
+public:
+	using Batch = typename decltype(std::declval<Source &>().Next())::value_type;
+
+	AsyncEnumerator() = delete;
+	AsyncEnumerator(Source & source, int initial_index = 0, int step = 1)
+		: source_(source), index_(initial_index), step_(step)
+	{
+		Prefetch();
+	}
+
+	// 次のまとまりをEnumerator<std::span<T>>として返す（終端ではstd::nulloptを返す）
+	Task<std::optional<Enumerator<Batch>>> Next()
+	{
+		if(!pending_)
+		{
+			co_return std::nullopt;
+		}
+
+		Task<Batch> & pending = *pending_;
+		Batch batch = co_await pending;
+
+		if(batch.empty())
+		{
+			pending_.reset();
+			co_return std::nullopt;
+		}
+
+		Prefetch();
+
+		int index = index_;
+		index_ += (int)batch.size() * step_;
+
+		co_return Enumerator<Batch>(batch, index, step_);
+	}
+
+private:
+	Source & source_;
+	int index_;
+	int step_;
+	std::optional<Task<Batch>> pending_;
+
+	void Prefetch()
+	{
+		pending_.emplace(source_.Next());
+		pending_->Start();
+	}
+};
+
+//-----------------------------------------------------------------------------------------
+// AsyncEnumerate関数
+//-----------------------------------------------------------------------------------------
+template <class Source>
+AsyncEnumerator<Source> AsyncEnumerate(Source & source, int initial_index = 0, int step = 1)
+{
+	return AsyncEnumerator<Source>(source, initial_index, step);
+}
+
+#endif // defined(__cpp_impl_coroutine)
+
+#endif // __IZADORI_ASYNCENUMERATOR_H__
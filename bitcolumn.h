@@ -0,0 +1,474 @@
+﻿//
+// bitcolumn.h
+//
+// Copyright (c) 2024 Izadori
+//
+// This software is released under the MIT License.
+// http://opensource.org/licenses/mit-license.php
+//
+
+#ifndef __IZADORI_BITCOLUMN_H__
+#define __IZADORI_BITCOLUMN_H__
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "bitmask.h"
+#include "parallel.h"
+#include "zipper.h"
+
+//-----------------------------------------------------------------------------------------
+// 1行を1ビットに詰めて格納する真偽値の列の実装（C++17対応のコンパイラが必要）
+//-----------------------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------------------
+// BitColumnクラス - 真偽値を64ビットワードに詰めて格納する列
+//   Zip()で他の列と組み合わせると、各行はReference（boolに変換・代入できるプロキシ）となる
+//   BitAnd()/BitOr()/CountAnd()/CountOr()で、Zip()した列をワード（64行）単位でまとめて処理する
+//   ワードは64バイト境界に確保し、並列処理の区間の境界は512行（1キャッシュライン）ごとに揃う
+//-----------------------------------------------------------------------------------------
+class BitColumn final
+{
+public:
+	static constexpr size_t word_bits = 64;
+	static constexpr size_t bits_per_row = 1;
+
+	//-------------------------------------------------------------------------------------
+	// Referenceクラス - n行目のビットへの参照
+	//-------------------------------------------------------------------------------------
+	class Reference final
+	{
+	public:
+		Reference(uint64_t * word, uint64_t mask) : word_(word), mask_(mask) {}
+		Reference(const Reference &) = default;
+
+		operator bool() const
+		{
+			return (*word_ & mask_) != 0;
+		}
+
+		Reference & operator=(bool value)
+		{
+			*word_ = value ? (*word_ | mask_) : (*word_ & ~mask_);
+			return *this;
+		}
+
+		Reference & operator=(const Reference & reference)
+		{
+			return *this = (bool)reference;
+		}
+
+	private:
+		uint64_t * word_;
+		uint64_t mask_;
+	};
+
+	//-------------------------------------------------------------------------------------
+	// Iteratorクラス - ランダムアクセスイテレータ
+	//-------------------------------------------------------------------------------------
+	class Iterator final
+	{
+	public:
+		using iterator_category = std::random_access_iterator_tag;
+		using value_type = bool;
+		using difference_type = std::ptrdiff_t;
+		using pointer = void;
+		using reference = Reference;
+
+		Iterator() : words_(nullptr), row_(0) {}
+
+		bool operator==(const Iterator & it) const
+		{
+			return row_ == it.row_;
+		}
+
+		bool operator!=(const Iterator & it) const
+		{
+			return row_ != it.row_;
+		}
+
+		Iterator & operator++()
+		{
+			row_++;
+			return *this;
+		}
+
+		Iterator operator++(int)
+		{
+			Iterator it = *this;
+			++*this;
+			return it;
+		}
+
+		Iterator & operator--()
+		{
+			row_--;
+			return *this;
+		}
+
+		Iterator operator--(int)
+		{
+			Iterator it = *this;
+			--*this;
+			return it;
+		}
+
+		Reference operator*() const
+		{
+			return Reference(words_ + row_ / word_bits, uint64_t(1) << (row_ % word_bits));
+		}
+
+		Iterator & operator+=(difference_type n)
+		{
+			row_ += n;
+			return *this;
+		}
+
+		Iterator & operator-=(difference_type n)
+		{
+			return *this += -n;
+		}
+
+		Iterator operator+(difference_type n) const
+		{
+			Iterator it = *this;
+			return it += n;
+		}
+
+		friend Iterator operator+(difference_type n, const Iterator & it)
+		{
+			return it + n;
+		}
+
+		Iterator operator-(difference_type n) const
+		{
+			Iterator it = *this;
+			return it -= n;
+		}
+
+		difference_type operator-(const Iterator & it) const
+		{
+			return (difference_type)row_ - (difference_type)it.row_;
+		}
+
+		Reference operator[](difference_type n) const
+		{
+			return *(*this + n);
+		}
+
+		bool operator<(const Iterator & it) const
+		{
+			return row_ < it.row_;
+		}
+
+		bool operator>(const Iterator & it) const
+		{
+			return it < *this;
+		}
+
+		bool operator<=(const Iterator & it) const
+		{
+			return !(it < *this);
+		}
+
+		bool operator>=(const Iterator & it) const
+		{
+			return !(*this < it);
+		}
+
+	private:
+		uint64_t * words_;
+		size_t row_;
+
+		Iterator(uint64_t * words, size_t row) : words_(words), row_(row) {}
+
+		friend BitColumn;
+	};
+
+	using iterator = Iterator;
+	using value_type = bool;
+
+	BitColumn() : size_(0) {}
+	BitColumn(size_t size, bool value = false) : size_(0)
+	{
+		resize(size, value);
+	}
+
+	// boolに変換できる値のコンテナから作る
+	template <class Container, typename = std::enable_if_t<!std::is_integral_v<Container>>>
+	explicit BitColumn(const Container & values) : size_(0)
+	{
+		for(auto && value : values)
+		{
+			push_back((bool)value);
+		}
+	}
+
+	Iterator begin()
+	{
+		return Iterator(words_.data(), 0);
+	}
+
+	Iterator end()
+	{
+		return Iterator(words_.data(), size_);
+	}
+
+	size_t size() const
+	{
+		return size_;
+	}
+
+	bool empty() const
+	{
+		return size_ == 0;
+	}
+
+	void reserve(size_t size)
+	{
+		words_.reserve((size + word_bits - 1) / word_bits);
+	}
+
+	void resize(size_t size, bool value = false)
+	{
+		if(size > size_ && value)
+		{
+			// 現在の末尾のワードの残りのビットを埋める
+			if(size_ % word_bits != 0)
+			{
+				words_.back() |= ~uint64_t(0) << (size_ % word_bits);
+			}
+
+			words_.resize((size + word_bits - 1) / word_bits, ~uint64_t(0));
+		}
+		else
+		{
+			words_.resize((size + word_bits - 1) / word_bits, 0);
+		}
+
+		size_ = size;
+		ClearPadding();
+	}
+
+	void push_back(bool value)
+	{
+		if(size_ % word_bits == 0)
+		{
+			words_.push_back(0);
+		}
+
+		words_.back() |= (uint64_t)value << (size_ % word_bits);
+		size_++;
+	}
+
+	void clear()
+	{
+		words_.clear();
+		size_ = 0;
+	}
+
+	Reference operator[](size_t n)
+	{
+		return Reference(&words_[n / word_bits], uint64_t(1) << (n % word_bits));
+	}
+
+	bool operator[](size_t n) const
+	{
+		return (words_[n / word_bits] >> (n % word_bits)) & 1;
+	}
+
+	size_t WordCount() const
+	{
+		return words_.size();
+	}
+
+	// 64行ずつのワードの配列（末尾のワードのsizeを超える部分のビットは0）
+	uint64_t * Words()
+	{
+		return words_.data();
+	}
+
+	const uint64_t * Words() const
+	{
+		return words_.data();
+	}
+
+	// EnumerateSelected()等に指定できるBitMaskとして参照する
+	BitMask AsMask() const
+	{
+		return BitMask(words_.data(), size_);
+	}
+
+	// 1のビットの総数を返す
+	size_t Count() const
+	{
+		size_t count = 0;
+
+		for(auto word : words_)
+		{
+			count += PopCount(word);
+		}
+
+		return count;
+	}
+
+	BitColumn & operator&=(const BitColumn & column)
+	{
+		return Combine(column, [](uint64_t a, uint64_t b) { return a & b; });
+	}
+
+	BitColumn & operator|=(const BitColumn & column)
+	{
+		return Combine(column, [](uint64_t a, uint64_t b) { return a | b; });
+	}
+
+	BitColumn & operator^=(const BitColumn & column)
+	{
+		return Combine(column, [](uint64_t a, uint64_t b) { return a ^ b; });
+	}
+
+	// 全てのビットを反転する
+	void Flip()
+	{
+		for(auto & word : words_)
+		{
+			word = ~word;
+		}
+
+		ClearPadding();
+	}
+
+private:
+	std::vector<uint64_t, CacheAlignedAllocator<uint64_t>> words_;
+	size_t size_;
+
+	void ClearPadding()
+	{
+		if(size_ % word_bits != 0)
+		{
+			words_.back() &= (uint64_t(1) << (size_ % word_bits)) - 1;
+		}
+	}
+
+	// 共通する行についてワードごとにop(a, b)を求める（columnが短い場合、残りの行はop(a, 0)とする）
+	template <typename BinaryOp>
+	BitColumn & Combine(const BitColumn & column, BinaryOp op)
+	{
+		size_t n = std::min(words_.size(), column.words_.size());
+
+		for(size_t w = 0; w < n; w++)
+		{
+			words_[w] = op(words_[w], column.words_[w]);
+		}
+
+		for(size_t w = n; w < words_.size(); w++)
+		{
+			words_[w] = op(words_[w], 0);
+		}
+
+		ClearPadding();
+		return *this;
+	}
+};
+
+//-----------------------------------------------------------------------------------------
+// ReduceBitColumns関数 - Zip()したBitColumnについて、ワードごとにop(word_0, word_1, ...)を求めて
+//   func(w, word)を呼び出す（Zipper<>の行数を超える部分のビットは0にする）
+//-----------------------------------------------------------------------------------------
+template <class... Columns, typename WordOp, typename Function>
+void ReduceBitColumns(Zipper<Columns...> & zipper, WordOp op, Function && func)
+{
+	static_assert((std::is_same_v<Columns, BitColumn> && ...), "ReduceBitColumns requires Zipper<BitColumn...>");
+
+	size_t size = zipper.size();
+	size_t words = (size + BitColumn::word_bits - 1) / BitColumn::word_bits;
+	auto columns = std::apply([](Columns &... columns) { return std::make_tuple((const uint64_t *)columns.Words()...); }, zipper.GetContainers());
+
+	for(size_t w = 0; w < words; w++)
+	{
+		uint64_t word = std::apply([&op, w](auto... column) { return op(column[w]...); }, columns);
+		size_t rest = size - w * BitColumn::word_bits;
+
+		func(w, rest >= BitColumn::word_bits ? word : word & ((uint64_t(1) << rest) - 1));
+	}
+}
+
+//-----------------------------------------------------------------------------------------
+// BitAnd関数・BitOr関数 - Zip()したBitColumnの各行の論理積・論理和をBitColumnとして返す
+//-----------------------------------------------------------------------------------------
+template <class... Columns>
+BitColumn BitAnd(Zipper<Columns...> & zipper)
+{
+	BitColumn result(zipper.size());
+	uint64_t * words = result.Words();
+
+	ReduceBitColumns(zipper, [](auto... words) { return (words & ...); }, [words](size_t w, uint64_t word) { words[w] = word; });
+
+	return result;
+}
+
+template <class... Columns>
+BitColumn BitAnd(Zipper<Columns...> && zipper)
+{
+	return BitAnd(zipper);
+}
+
+template <class... Columns>
+BitColumn BitOr(Zipper<Columns...> & zipper)
+{
+	BitColumn result(zipper.size());
+	uint64_t * words = result.Words();
+
+	ReduceBitColumns(zipper, [](auto... words) { return (words | ...); }, [words](size_t w, uint64_t word) { words[w] = word; });
+
+	return result;
+}
+
+template <class... Columns>
+BitColumn BitOr(Zipper<Columns...> && zipper)
+{
+	return BitOr(zipper);
+}
+
+//-----------------------------------------------------------------------------------------
+// CountAnd関数・CountOr関数 - 論理積・論理和が1となる行数を、BitColumnを作らずに数える
+//-----------------------------------------------------------------------------------------
+template <class... Columns>
+size_t CountAnd(Zipper<Columns...> & zipper)
+{
+	size_t count = 0;
+
+	ReduceBitColumns(zipper, [](auto... words) { return (words & ...); }, [&count](size_t, uint64_t word) { count += PopCount(word); });
+
+	return count;
+}
+
+template <class... Columns>
+size_t CountAnd(Zipper<Columns...> && zipper)
+{
+	return CountAnd(zipper);
+}
+
+template <class... Columns>
+size_t CountOr(Zipper<Columns...> & zipper)
+{
+	size_t count = 0;
+
+	ReduceBitColumns(zipper, [](auto... words) { return (words | ...); }, [&count](size_t, uint64_t word) { count += PopCount(word); });
+
+	return count;
+}
+
+template <class... Columns>
+size_t CountOr(Zipper<Columns...> && zipper)
+{
+	return CountOr(zipper);
+}
+
+#endif // __IZADORI_BITCOLUMN_H__
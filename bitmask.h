@@ -0,0 +1,132 @@
+﻿//
+// bitmask.h
+//
+// Copyright (c) 2024 Izadori
+//
+// This software is released under the MIT License.
+// http://opensource.org/licenses/mit-license.php
+//
+
+#ifndef __IZADORI_BITMASK_H__
+#define __IZADORI_BITMASK_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+//-----------------------------------------------------------------------------------------
+// 64ビットワード単位のビットマップとビット演算の補助関数（C++17対応のコンパイラが必要）
+//   -mbmi -mpopcnt（MSVCでは/arch:AVX2）を指定するとtzcnt/popcnt命令が使われる
+//-----------------------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------------------
+// CountTrailingZeros関数 - 最下位から連続する0のビット数を返す（xは0以外）
+//-----------------------------------------------------------------------------------------
+inline int CountTrailingZeros(uint64_t x)
+{
+#if defined(_MSC_VER)
+	unsigned long index;
+	_BitScanForward64(&index, x);
+	return (int)index;
+#else
+	return __builtin_ctzll(x);
+#endif
+}
+
+//-----------------------------------------------------------------------------------------
+// BitWidth関数 - xを表すのに必要なビット数を返す（xが0の場合は0）
+//-----------------------------------------------------------------------------------------
+inline int BitWidth(uint64_t x)
+{
+	if(x == 0)
+	{
+		return 0;
+	}
+
+#if defined(_MSC_VER)
+	unsigned long index;
+	_BitScanReverse64(&index, x);
+	return (int)index + 1;
+#else
+	return 64 - __builtin_clzll(x);
+#endif
+}
+
+//-----------------------------------------------------------------------------------------
+// PopCount関数 - 1のビット数を返す
+//-----------------------------------------------------------------------------------------
+inline int PopCount(uint64_t x)
+{
+#if defined(_MSC_VER)
+	return (int)__popcnt64(x);
+#else
+	return __builtin_popcountll(x);
+#endif
+}
+
+//-----------------------------------------------------------------------------------------
+// BitMaskクラス - 64ビットワードの配列をsizeビットのビットマップとして参照する
+//   n番目のビットはwords[n / 64]の下位から(n % 64)番目のビット
+//-----------------------------------------------------------------------------------------
+class BitMask final
+{
+public:
+	static constexpr size_t word_bits = 64;
+
+	BitMask() = delete;
+	BitMask(const uint64_t * words, size_t size) : words_(words), size_(size) {}
+
+	template <class Container>
+	BitMask(const Container & words, size_t size) : words_(std::data(words)), size_(size) {}
+
+	size_t size() const
+	{
+		return size_;
+	}
+
+	size_t WordCount() const
+	{
+		return (size_ + word_bits - 1) / word_bits;
+	}
+
+	// n番目のワードを返す（sizeを超える部分のビットは0にする）
+	uint64_t Word(size_t n) const
+	{
+		size_t rest = size_ - n * word_bits;
+		return rest >= word_bits ? words_[n] : words_[n] & ((uint64_t(1) << rest) - 1);
+	}
+
+	bool operator[](size_t n) const
+	{
+		return (words_[n / word_bits] >> (n % word_bits)) & 1;
+	}
+
+	// 1のビットの総数を返す
+	size_t Count() const
+	{
+		size_t count = 0;
+
+		for(size_t i = 0; i < WordCount(); i++)
+		{
+			count += PopCount(Word(i));
+		}
+
+		return count;
+	}
+
+	// 先頭からsizeビットだけを参照するBitMaskを返す
+	BitMask Truncate(size_t size) const
+	{
+		return BitMask(words_, size < size_ ? size : size_);
+	}
+
+private:
+	const uint64_t * words_;
+	size_t size_;
+};
+
+#endif // __IZADORI_BITMASK_H__
@@ -0,0 +1,224 @@
+﻿//
+// collector.h
+//
+// Copyright (c) 2024 Izadori
+//
+// This software is released under the MIT License.
+// http://opensource.org/licenses/mit-license.php
+//
+
+#ifndef __IZADORI_COLLECTOR_H__
+#define __IZADORI_COLLECTOR_H__
+
+#include <cstddef>
+#include <initializer_list>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "parallel.h"
+#include "zipper.h"
+
+//-----------------------------------------------------------------------------------------
+// Zipper等の結果を列ごとのコンテナに書き出すCollect()関数の実装（C++17対応のコンパイラが必要）
+//-----------------------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------------------
+// ResizeColumns関数 - Zipperの全ての列をsizeにリサイズする
+//-----------------------------------------------------------------------------------------
+template <class... Containers>
+void ResizeColumns(Zipper<Containers...> & zipper, size_t size)
+{
+	std::apply([size](auto &... columns) {
+		using swallow = std::initializer_list<int>;
+		(void)swallow{(columns.resize(size), 0)...};
+	}, zipper.GetContainers());
+}
+
+//-----------------------------------------------------------------------------------------
+// CollectInto関数 - sourceの各要素（タプル）を出力先の各列に追加する
+//   sourceの要素数がsize()で分かる場合（HasSize<>）は出力先を正確なサイズで一度だけ確保し、
+//   分からない場合（一度しか読めない列を含むZipper<>等）は全ての列の容量を揃えて倍々に拡張する
+//-----------------------------------------------------------------------------------------
+template <class... Outputs, class Source>
+void CollectInto(Zipper<Outputs...> && output, Source && source)
+{
+	auto inserter = std::apply(ZipInserter<Outputs...>, output.GetContainers());
+
+	if constexpr(HasSize<std::remove_reference_t<Source>>::value)
+	{
+		inserter.Reserve(source.size());
+
+		for(auto it = source.begin(); it != source.end(); ++it)
+		{
+			*inserter = *it;
+		}
+	}
+	else
+	{
+		size_t count = 0;
+		size_t capacity = 0;
+
+		for(auto it = source.begin(); it != source.end(); ++it)
+		{
+			if(count == capacity)
+			{
+				size_t grow = capacity == 0 ? 16 : capacity;
+				inserter.Reserve(grow);
+				capacity += grow;
+			}
+
+			*inserter = *it;
+			count++;
+		}
+	}
+}
+
+template <class... Outputs, class Source>
+void CollectInto(Zipper<Outputs...> & output, Source && source)
+{
+	CollectInto(std::move(output), std::forward<Source>(source));
+}
+
+//-----------------------------------------------------------------------------------------
+// CollectInto関数（並列版） - 出力先を一度だけリサイズし、各スレッドが互いに重ならない区間に書き込む
+//   出力先はresize()可能なランダムアクセスコンテナ、sourceはsize()とoperator[]を持つ範囲
+//   （ランダムアクセス可能なコンテナのZipper等）である必要がある
+//   各スレッドの書き込み範囲の境界は、出力先の全ての列のキャッシュラインの境界に揃える
+//-----------------------------------------------------------------------------------------
+template <class... Outputs, class Source>
+void CollectInto(Zipper<Outputs...> && output, Source && source, unsigned int num_threads)
+{
+	size_t offset = output.size();
+	size_t size = source.size();
+
+	ResizeColumns(output, offset + size);
+
+	ParallelFor(size, [&output, &source, offset](size_t begin, size_t end, unsigned int) {
+		for(size_t i = begin; i < end; i++)
+		{
+			output[offset + i] = source[i];
+		}
+	}, num_threads, GetRowAlignment(output).Offset(offset));
+}
+
+template <class... Outputs, class Source>
+void CollectInto(Zipper<Outputs...> & output, Source && source, unsigned int num_threads)
+{
+	CollectInto(std::move(output), std::forward<Source>(source), num_threads);
+}
+
+//-----------------------------------------------------------------------------------------
+// Collect関数 - 列ごとのコンテナのタプル（SoA）を生成し、sourceの内容を書き出して返す
+//-----------------------------------------------------------------------------------------
+template <class SoA, class Source>
+SoA Collect(Source && source)
+{
+	SoA result;
+	CollectInto(std::apply([](auto &... columns) { return Zip(columns...); }, result), std::forward<Source>(source));
+	return result;
+}
+
+//-----------------------------------------------------------------------------------------
+// Collect関数（並列版）
+//-----------------------------------------------------------------------------------------
+template <class SoA, class Source>
+SoA Collect(Source && source, unsigned int num_threads)
+{
+	SoA result;
+	CollectInto(std::apply([](auto &... columns) { return Zip(columns...); }, result), std::forward<Source>(source), num_threads);
+	return result;
+}
+
+//-----------------------------------------------------------------------------------------
+// Compact関数 - predicate(row)が真となる行だけを出力先の末尾に詰めて書き出し、その行数を返す
+//   分岐予測の失敗を避けるため、全ての行を書き込み位置に書いてから位置をpredicateの結果だけ進める
+//   入力・出力ともにランダムアクセス可能なコンテナのZipperである必要がある
+//-----------------------------------------------------------------------------------------
+template <class... Inputs, class Predicate, class... Outputs>
+size_t Compact(Zipper<Inputs...> && input, Predicate && predicate, Zipper<Outputs...> && output)
+{
+	size_t offset = output.size();
+	size_t size = input.size();
+	size_t count = 0;
+
+	ResizeColumns(output, offset + size);
+
+	for(size_t i = 0; i < size; i++)
+	{
+		auto row = input[i];
+		output[offset + count] = row;
+		count += predicate(row) ? 1 : 0;
+	}
+
+	ResizeColumns(output, offset + count);
+	return count;
+}
+
+template <class... Inputs, class Predicate, class... Outputs>
+size_t Compact(Zipper<Inputs...> & input, Predicate && predicate, Zipper<Outputs...> & output)
+{
+	return Compact(std::move(input), std::forward<Predicate>(predicate), std::move(output));
+}
+
+//-----------------------------------------------------------------------------------------
+// Compact関数（並列版） - 区間ごとに選択行数を数え、その排他的累積和から各区間の書き込み位置を決めて書き出す
+//-----------------------------------------------------------------------------------------
+template <class... Inputs, class Predicate, class... Outputs>
+size_t Compact(Zipper<Inputs...> && input, Predicate && predicate, Zipper<Outputs...> && output, unsigned int num_threads)
+{
+	size_t offset = output.size();
+	size_t size = input.size();
+	size_t chunks = GetThreadCount(num_threads);
+	std::vector<unsigned char> flags(size);
+	std::vector<size_t> counts(chunks + 1, 0);
+	std::vector<size_t> lasts(chunks, 0);
+
+	// 1パス目：各行の判定結果と区間ごとの選択行数、最後に選択された行の次の位置を求める
+	ParallelFor(size, [&](size_t begin, size_t end, unsigned int chunk) {
+		size_t count = 0;
+		size_t last = begin;
+
+		for(size_t i = begin; i < end; i++)
+		{
+			unsigned char flag = predicate(input[i]) ? 1 : 0;
+			flags[i] = flag;
+			count += flag;
+			last = flag ? i + 1 : last;
+		}
+
+		counts[chunk + 1] = count;
+		lasts[chunk] = last;
+	}, num_threads);
+
+	// 排他的累積和：counts[chunk]が各区間の書き込み開始位置になる
+	for(size_t c = 0; c < chunks; c++)
+	{
+		counts[c + 1] += counts[c];
+	}
+
+	ResizeColumns(output, offset + size);
+
+	// 2パス目：最後に選択された行までを分岐なしで書き出す（それ以降は次の区間の領域を壊すため書かない）
+	ParallelFor(size, [&](size_t begin, size_t, unsigned int chunk) {
+		size_t position = offset + counts[chunk];
+
+		for(size_t i = begin; i < lasts[chunk]; i++)
+		{
+			output[position] = input[i];
+			position += flags[i];
+		}
+	}, num_threads);
+
+	ResizeColumns(output, offset + counts[chunks]);
+	return counts[chunks];
+}
+
+template <class... Inputs, class Predicate, class... Outputs>
+size_t Compact(Zipper<Inputs...> & input, Predicate && predicate, Zipper<Outputs...> & output, unsigned int num_threads)
+{
+	return Compact(std::move(input), std::forward<Predicate>(predicate), std::move(output), num_threads);
+}
+
+#endif // __IZADORI_COLLECTOR_H__
@@ -0,0 +1,436 @@
+﻿//
+// columnfile.h
+//
+// Copyright (c) 2024 Izadori
+//
+// This software is released under the MIT License.
+// http://opensource.org/licenses/mit-license.php
+//
+
+#ifndef __IZADORI_COLUMNFILE_H__
+#define __IZADORI_COLUMNFILE_H__
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <type_traits>
+#include <vector>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "rowranges.h"
+#include "zipper.h"
+
+//-----------------------------------------------------------------------------------------
+// ゾーンマップつきの列ファイルの書き込み・読み込みの実装（C++17対応のコンパイラが必要）
+//   1つの列を1つのファイルに、次の順に格納する（数値はすべて実行環境のバイトオーダー）
+//     値        : rows個のT（ファイルの先頭から）
+//     ゾーンマップ: ブロック（block_rows行ずつ）ごとのZoneMap<T>（zone_offsetバイト目から）
+//     フッタ    : ColumnFileFooter（ファイルの末尾）
+//-----------------------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------------------
+// ZoneMapクラス - ブロックに含まれる値の最小値・最大値と行数
+//-----------------------------------------------------------------------------------------
+template <typename T>
+struct ZoneMap
+{
+	T min;
+	T max;
+	uint64_t rows;
+};
+
+//-----------------------------------------------------------------------------------------
+// ColumnFileFooterクラス - 列ファイルの末尾に置く固定長のフッタ
+//   kindは値の種類（0: 符号なし整数、1: 符号つき整数、2: 浮動小数点数、3: その他）
+//-----------------------------------------------------------------------------------------
+struct ColumnFileFooter
+{
+	static constexpr char signature[8] = {'I', 'Z', 'C', 'O', 'L', '0', '0', '1'};
+
+	char magic[8];
+	uint32_t value_size;
+	uint32_t kind;
+	uint64_t rows;
+	uint64_t block_rows;
+	uint64_t zone_offset;
+	uint64_t block_count;
+
+	template <typename T>
+	static constexpr uint32_t GetKind()
+	{
+		return std::is_floating_point_v<T> ? 2 : std::is_integral_v<T> ? (std::is_signed_v<T> ? 1 : 0) : 3;
+	}
+};
+
+//-----------------------------------------------------------------------------------------
+// WriteColumnFile関数 - columnの値をblock_rows行ずつのブロックに分け、ゾーンマップとともに書き込む
+//-----------------------------------------------------------------------------------------
+template <class Container>
+void WriteColumnFile(const std::string & path, Container & column, size_t block_rows = 65536)
+{
+	using T = std::remove_cv_t<GetValueType<Container>>;
+	static_assert(std::is_trivially_copyable_v<T>, "WriteColumnFile requires a trivially copyable type");
+
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+	std::vector<ZoneMap<T>> zones;
+	std::vector<T> block;
+	uint64_t rows = 0;
+
+	block_rows = std::max<size_t>(1, block_rows);
+	block.reserve(block_rows);
+
+	auto flush = [&]() {
+		ZoneMap<T> zone;
+
+		std::memset(&zone, 0, sizeof(zone));
+		zone.min = *std::min_element(block.begin(), block.end());
+		zone.max = *std::max_element(block.begin(), block.end());
+		zone.rows = block.size();
+
+		zones.push_back(zone);
+		file.write((const char *)block.data(), (std::streamsize)(block.size() * sizeof(T)));
+		rows += block.size();
+		block.clear();
+	};
+
+	for(auto && value : column)
+	{
+		block.push_back(value);
+
+		if(block.size() == block_rows)
+		{
+			flush();
+		}
+	}
+
+	if(!block.empty())
+	{
+		flush();
+	}
+
+	// ゾーンマップはZoneMap<T>の境界に揃える
+	uint64_t zone_offset = (rows * sizeof(T) + alignof(ZoneMap<T>) - 1) / alignof(ZoneMap<T>) * alignof(ZoneMap<T>);
+	std::vector<char> padding((size_t)(zone_offset - rows * sizeof(T)), 0);
+	ColumnFileFooter footer;
+
+	std::memset(&footer, 0, sizeof(footer));
+	std::memcpy(footer.magic, ColumnFileFooter::signature, sizeof(footer.magic));
+	footer.value_size = (uint32_t)sizeof(T);
+	footer.kind = ColumnFileFooter::GetKind<T>();
+	footer.rows = rows;
+	footer.block_rows = block_rows;
+	footer.zone_offset = zone_offset;
+	footer.block_count = zones.size();
+
+	file.write(padding.data(), (std::streamsize)padding.size());
+	file.write((const char *)zones.data(), (std::streamsize)(zones.size() * sizeof(ZoneMap<T>)));
+	file.write((const char *)&footer, sizeof(footer));
+	file.close();
+
+	if(!file)
+	{
+		throw std::runtime_error("WriteColumnFile: failed to write " + path);
+	}
+}
+
+//-----------------------------------------------------------------------------------------
+// MappedFileクラス - ファイル全体を読み込み専用でメモリにマップする
+//-----------------------------------------------------------------------------------------
+class MappedFile final
+{
+public:
+	MappedFile(const std::string & path) : data_(nullptr), size_(0)
+	{
+#if defined(_WIN32)
+		HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		LARGE_INTEGER bytes;
+
+		if(file == INVALID_HANDLE_VALUE || !GetFileSizeEx(file, &bytes))
+		{
+			int error = (int)GetLastError();
+
+			if(file != INVALID_HANDLE_VALUE)
+			{
+				CloseHandle(file);
+			}
+
+			throw std::system_error(error, std::system_category(), path);
+		}
+
+		size_ = (size_t)bytes.QuadPart;
+		mapping_ = size_ > 0 ? CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr) : nullptr;
+		data_ = mapping_ != nullptr ? (const char *)MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0) : nullptr;
+		CloseHandle(file);
+
+		if(size_ > 0 && data_ == nullptr)
+		{
+			int error = (int)GetLastError();
+			Unmap();
+			throw std::system_error(error, std::system_category(), path);
+		}
+#else
+		int file = open(path.c_str(), O_RDONLY);
+		struct stat status;
+
+		if(file < 0 || fstat(file, &status) != 0)
+		{
+			int error = errno;
+
+			if(file >= 0)
+			{
+				close(file);
+			}
+
+			throw std::system_error(error, std::generic_category(), path);
+		}
+
+		size_ = (size_t)status.st_size;
+
+		if(size_ > 0)
+		{
+			void * data = mmap(nullptr, size_, PROT_READ, MAP_SHARED, file, 0);
+			int error = errno;
+
+			close(file);
+
+			if(data == MAP_FAILED)
+			{
+				throw std::system_error(error, std::generic_category(), path);
+			}
+
+			data_ = (const char *)data;
+		}
+		else
+		{
+			close(file);
+		}
+#endif
+	}
+
+	MappedFile(const MappedFile &) = delete;
+	MappedFile & operator=(const MappedFile &) = delete;
+
+	~MappedFile()
+	{
+		Unmap();
+	}
+
+	const char * data() const
+	{
+		return data_;
+	}
+
+	size_t size() const
+	{
+		return size_;
+	}
+
+private:
+	const char * data_;
+	size_t size_;
+
+#if defined(_WIN32)
+	HANDLE mapping_ = nullptr;
+
+	void Unmap()
+	{
+		if(data_ != nullptr)
+		{
+			UnmapViewOfFile(data_);
+		}
+
+		if(mapping_ != nullptr)
+		{
+			CloseHandle(mapping_);
+		}
+	}
+#else
+	void Unmap()
+	{
+		if(data_ != nullptr)
+		{
+			munmap((void *)data_, size_);
+		}
+	}
+#endif
+};
+
+//-----------------------------------------------------------------------------------------
+// ColumnFileクラス - WriteColumnFile()で書き込んだ列ファイルをメモリにマップして参照するビュー
+//   マップしたファイルを共有するのでコピーは軽く、Zip()の中では値として保持される
+//   値は連続したメモリ領域にあるので、Zipper<>のランダムアクセス・並列処理がそのまま使える
+//-----------------------------------------------------------------------------------------
+template <typename T>
+class ColumnFile final
+{
+	static_assert(std::is_trivially_copyable_v<T>, "ColumnFile<T> requires a trivially copyable type");
+
+public:
+	using value_type = T;
+	using iterator = const T *;
+
+	ColumnFile(const std::string & path) : file_(std::make_shared<MappedFile>(path))
+	{
+		ColumnFileFooter footer;
+
+		if(file_->size() < sizeof(footer))
+		{
+			throw std::runtime_error("ColumnFile: not a column file: " + path);
+		}
+
+		std::memcpy(&footer, file_->data() + file_->size() - sizeof(footer), sizeof(footer));
+
+		// 破損したフッタでも桁あふれしないように、乗算ではなく除算で範囲を確かめる
+		uint64_t body = file_->size() - sizeof(footer);
+
+		if(std::memcmp(footer.magic, ColumnFileFooter::signature, sizeof(footer.magic)) != 0
+			|| footer.value_size != sizeof(T) || footer.kind != ColumnFileFooter::GetKind<T>()
+			|| footer.zone_offset > body || footer.zone_offset % alignof(ZoneMap<T>) != 0
+			|| footer.rows > footer.zone_offset / sizeof(T)
+			|| footer.block_count > (body - footer.zone_offset) / sizeof(ZoneMap<T>)
+			|| footer.block_rows == 0
+			|| footer.block_count != footer.rows / footer.block_rows + (footer.rows % footer.block_rows != 0 ? 1 : 0))
+		{
+			throw std::runtime_error("ColumnFile: invalid or mismatched column file: " + path);
+		}
+
+		data_ = (const T *)file_->data();
+		size_ = (size_t)footer.rows;
+		block_rows_ = (size_t)footer.block_rows;
+		zones_ = (const ZoneMap<T> *)(file_->data() + footer.zone_offset);
+		block_count_ = (size_t)footer.block_count;
+	}
+
+	const T * begin() const
+	{
+		return data_;
+	}
+
+	const T * end() const
+	{
+		return data_ + size_;
+	}
+
+	const T * data() const
+	{
+		return data_;
+	}
+
+	size_t size() const
+	{
+		return size_;
+	}
+
+	const T & operator[](size_t n) const
+	{
+		return data_[n];
+	}
+
+	size_t BlockRows() const
+	{
+		return block_rows_;
+	}
+
+	size_t BlockCount() const
+	{
+		return block_count_;
+	}
+
+	const ZoneMap<T> & GetZone(size_t block) const
+	{
+		return zones_[block];
+	}
+
+	// 値が[min, max]に含まれうるブロックの行の区間を返す
+	//   ゾーンマップで除外できない行も含むので、各行の値は改めて確認する必要がある
+	RowRanges FindBlocks(const T & min, const T & max) const
+	{
+		RowRanges ranges;
+
+		for(size_t b = 0; b < block_count_; b++)
+		{
+			if(!(zones_[b].max < min) && !(max < zones_[b].min))
+			{
+				AddBlock(ranges, b);
+			}
+		}
+
+		return ranges;
+	}
+
+	// ゾーンマップについてpred(zone)がtrueとなるブロックの行の区間を返す
+	template <typename Predicate>
+	RowRanges FindBlocksIf(Predicate && pred) const
+	{
+		RowRanges ranges;
+
+		for(size_t b = 0; b < block_count_; b++)
+		{
+			if(pred(zones_[b]))
+			{
+				AddBlock(ranges, b);
+			}
+		}
+
+		return ranges;
+	}
+
+private:
+	std::shared_ptr<MappedFile> file_;
+	const T * data_;
+	size_t size_;
+	size_t block_rows_;
+	const ZoneMap<T> * zones_;
+	size_t block_count_;
+
+	// b番目のブロックの行の区間を追加する（ゾーンマップの行数は列の行数を超えないように切り詰める）
+	void AddBlock(RowRanges & ranges, size_t b) const
+	{
+		size_t begin = b * block_rows_;
+		ranges.Add(begin, begin + (size_t)std::min<uint64_t>(zones_[b].rows, size_ - begin));
+	}
+};
+
+template <typename T>
+struct IsView<ColumnFile<T>> : std::true_type {};
+
+//-----------------------------------------------------------------------------------------
+// OpenColumnFiles関数 - 列ファイルを開き、全ての列をZip()したZipper<ColumnFile<T>...>を返す
+//   auto table = OpenColumnFiles<int64_t, double>("time.col", "price.col");
+//   for(auto [i, row] : EnumerateSelected(table, std::get<0>(table.GetContainers()).FindBlocks(t0, t1)))
+//-----------------------------------------------------------------------------------------
+template <typename... Types, typename... Paths>
+Zipper<ColumnFile<Types>...> OpenColumnFiles(const Paths &... paths)
+{
+	static_assert(sizeof...(Types) == sizeof...(Paths), "OpenColumnFiles requires one path per column type");
+
+	std::tuple<ColumnFile<Types>...> columns{ColumnFile<Types>(std::string(paths))...};
+
+	return std::apply([](ColumnFile<Types> &... columns) {
+		return Zipper<ColumnFile<Types>...>(columns...);
+	}, columns);
+}
+
+#endif // __IZADORI_COLUMNFILE_H__
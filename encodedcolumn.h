@@ -0,0 +1,487 @@
+﻿//
+// encodedcolumn.h
+//
+// Copyright (c) 2024 Izadori
+//
+// This software is released under the MIT License.
+// http://opensource.org/licenses/mit-license.php
+//
+
+#ifndef __IZADORI_ENCODEDCOLUMN_H__
+#define __IZADORI_ENCODEDCOLUMN_H__
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <type_traits>
+#include <vector>
+
+#include "bitmask.h"
+
+//-----------------------------------------------------------------------------------------
+// 整数の列をブロックごとに圧縮し、Zip()の中で展開しながら読み出す範囲の実装（C++17対応のコンパイラが必要）
+//-----------------------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------------------
+// ColumnEncoding - ブロックの符号化方式
+//   Delta           : 先頭の値と、隣り合う値の差をFrameOfReferenceで符号化する（時刻・連番向け）
+//   FrameOfReference: ブロックの最小値との差を、最大の差を表せるビット数で詰めて格納する
+//   RunLength       : 同じ値が続く区間（ラン）ごとに、値と長さを格納する
+//   Dictionary      : ブロック内の異なる値の辞書と、辞書の位置をビット数を詰めて格納する
+//   Auto            : ブロックごとに、最も小さくなる方式を選ぶ
+//-----------------------------------------------------------------------------------------
+enum class ColumnEncoding : uint8_t
+{
+	Auto,
+	Delta,
+	FrameOfReference,
+	RunLength,
+	Dictionary,
+};
+
+//-----------------------------------------------------------------------------------------
+// PackBits関数 - values[0, n)の下位widthビットずつをwordsの末尾に詰めて追加する
+//-----------------------------------------------------------------------------------------
+inline void PackBits(std::vector<uint64_t> & words, const uint64_t * values, size_t n, int width)
+{
+	if(width == 0)
+	{
+		return;
+	}
+
+	size_t offset = words.size();
+
+	words.resize(offset + (n * width + 63) / 64, 0);
+
+	for(size_t i = 0; i < n; i++)
+	{
+		size_t bit = i * width;
+		size_t word = offset + bit / 64;
+		int shift = (int)(bit % 64);
+
+		words[word] |= values[i] << shift;
+
+		if(shift + width > 64)
+		{
+			words[word + 1] |= values[i] >> (64 - shift);
+		}
+	}
+}
+
+//-----------------------------------------------------------------------------------------
+// UnpackBits関数 - PackBits()で詰めたi番目の値を返す
+//-----------------------------------------------------------------------------------------
+inline uint64_t UnpackBits(const uint64_t * words, size_t i, int width)
+{
+	if(width == 0)
+	{
+		return 0;
+	}
+
+	size_t bit = i * width;
+	int shift = (int)(bit % 64);
+	uint64_t value = words[bit / 64] >> shift;
+
+	if(shift + width > 64)
+	{
+		value |= words[bit / 64 + 1] << (64 - shift);
+	}
+
+	return width == 64 ? value : value & ((uint64_t(1) << width) - 1);
+}
+
+//-----------------------------------------------------------------------------------------
+// EncodedColumnクラス - 整数の列をblock_rows行ずつのブロックに分けて圧縮して保持する
+//   イテレータはブロックごとに作業用のバッファへ展開する（バッファは列ごとに1つなので、
+//   一度に1つのイテレータだけが読み進められる）
+//   全ての行を並列に処理する場合は、DecodeBlock()でブロックごとに展開する
+//-----------------------------------------------------------------------------------------
+template <typename T>
+class EncodedColumn final
+{
+	static_assert(std::is_integral_v<T>, "EncodedColumn<T> requires an integral type");
+
+public:
+	using value_type = T;
+
+	// ブロックの符号化の情報
+	struct Block
+	{
+		ColumnEncoding encoding;
+		int width;          // 詰めて格納した値のビット数
+		size_t rows;
+		size_t count;       // ランの数、または辞書の大きさ
+		size_t offset;      // words_の中での位置
+		uint64_t base;      // 最小値（FrameOfReference）、先頭の値（Delta）
+		uint64_t reference; // 隣り合う値の差の最小値（Delta）
+	};
+
+	EncodedColumn() = delete;
+
+	template <class Container>
+	EncodedColumn(Container & column, ColumnEncoding encoding = ColumnEncoding::Auto, size_t block_rows = 1024)
+		: size_(0), block_rows_(std::max<size_t>(1, block_rows))
+	{
+		std::vector<uint64_t> values;
+
+		values.reserve(block_rows_);
+
+		for(auto && value : column)
+		{
+			values.push_back(ToBits((T)value));
+
+			if(values.size() == block_rows_)
+			{
+				Encode(values, encoding);
+				values.clear();
+			}
+		}
+
+		if(!values.empty())
+		{
+			Encode(values, encoding);
+		}
+
+		scratch_.resize(block_rows_);
+	}
+
+	//-------------------------------------------------------------------------------------
+	// Iteratorクラス - 入力イテレータ
+	//   ブロックの終わりまで進むと、次のブロックを作業用のバッファに展開する
+	//-------------------------------------------------------------------------------------
+	class Iterator final
+	{
+	public:
+		using iterator_category = std::input_iterator_tag;
+		using value_type = T;
+		using difference_type = std::ptrdiff_t;
+		using pointer = const T *;
+		using reference = const T &;
+
+		Iterator() : column_(nullptr), row_(0), block_end_(0), current_(nullptr) {}
+
+		bool operator==(const Iterator & it) const
+		{
+			return row_ == it.row_;
+		}
+
+		bool operator!=(const Iterator & it) const
+		{
+			return row_ != it.row_;
+		}
+
+		Iterator & operator++()
+		{
+			current_++;
+
+			if(++row_ == block_end_ && row_ < column_->size_)
+			{
+				size_t block = row_ / column_->block_rows_;
+
+				current_ = column_->Load(block);
+				block_end_ = row_ + column_->blocks_[block].rows;
+			}
+
+			return *this;
+		}
+
+		Iterator operator++(int)
+		{
+			Iterator it = *this;
+			++*this;
+			return it;
+		}
+
+		const T & operator*() const
+		{
+			return *current_;
+		}
+
+		const T * operator->() const
+		{
+			return current_;
+		}
+
+	private:
+		EncodedColumn * column_;
+		size_t row_;
+		size_t block_end_;
+		const T * current_;
+
+		friend EncodedColumn;
+	};
+
+	using iterator = Iterator;
+
+	Iterator begin()
+	{
+		Iterator it;
+
+		it.column_ = this;
+
+		if(size_ > 0)
+		{
+			it.current_ = Load(0);
+			it.block_end_ = blocks_[0].rows;
+		}
+
+		return it;
+	}
+
+	Iterator end()
+	{
+		Iterator it;
+		it.column_ = this;
+		it.row_ = size_;
+		return it;
+	}
+
+	size_t size() const
+	{
+		return size_;
+	}
+
+	size_t BlockRows() const
+	{
+		return block_rows_;
+	}
+
+	size_t BlockCount() const
+	{
+		return blocks_.size();
+	}
+
+	const Block & GetBlock(size_t block) const
+	{
+		return blocks_[block];
+	}
+
+	// 圧縮したデータの大きさ（バイト）を返す
+	size_t CompressedBytes() const
+	{
+		return words_.size() * sizeof(uint64_t) + blocks_.size() * sizeof(Block);
+	}
+
+	// blockを展開してoutに書き込み、その行数を返す（outはBlockRows()個以上の要素を持つこと）
+	size_t DecodeBlock(size_t block, T * out) const
+	{
+		const Block & b = blocks_[block];
+		const uint64_t * words = words_.data() + b.offset;
+
+		switch(b.encoding)
+		{
+		case ColumnEncoding::Delta:
+		{
+			uint64_t value = b.base;
+
+			out[0] = FromBits(value);
+
+			for(size_t i = 1; i < b.rows; i++)
+			{
+				value += b.reference + UnpackBits(words, i - 1, b.width);
+				out[i] = FromBits(value);
+			}
+
+			break;
+		}
+		case ColumnEncoding::RunLength:
+		{
+			const uint64_t * lengths = words + b.count;
+			size_t i = 0;
+
+			for(size_t r = 0; r < b.count; r++)
+			{
+				T value = FromBits(words[r]);
+				size_t end = i + (size_t)UnpackBits(lengths, r, b.width) + 1;
+
+				std::fill(out + i, out + end, value);
+				i = end;
+			}
+
+			break;
+		}
+		case ColumnEncoding::Dictionary:
+		{
+			const uint64_t * codes = words + b.count;
+
+			for(size_t i = 0; i < b.rows; i++)
+			{
+				out[i] = FromBits(words[UnpackBits(codes, i, b.width)]);
+			}
+
+			break;
+		}
+		default:
+		{
+			for(size_t i = 0; i < b.rows; i++)
+			{
+				out[i] = FromBits(b.base + UnpackBits(words, i, b.width));
+			}
+
+			break;
+		}
+		}
+
+		return b.rows;
+	}
+
+private:
+	size_t size_;
+	size_t block_rows_;
+	std::vector<Block> blocks_;
+	std::vector<uint64_t> words_;
+	std::vector<T> scratch_;
+
+	// 符号の有無に関わらず、値を64ビットに広げて扱う（差は2^64を法として計算する）
+	static uint64_t ToBits(T value)
+	{
+		return (uint64_t)(std::conditional_t<std::is_signed_v<T>, int64_t, uint64_t>)value;
+	}
+
+	static T FromBits(uint64_t bits)
+	{
+		return (T)bits;
+	}
+
+	const T * Load(size_t block)
+	{
+		DecodeBlock(block, scratch_.data());
+		return scratch_.data();
+	}
+
+	// 値の大小は元の型で比較する
+	static bool Less(uint64_t a, uint64_t b)
+	{
+		return FromBits(a) < FromBits(b);
+	}
+
+	void Encode(const std::vector<uint64_t> & values, ColumnEncoding encoding)
+	{
+		size_t n = values.size();
+		Block block = {ColumnEncoding::FrameOfReference, 0, n, 0, words_.size(), 0, 0};
+
+		// FrameOfReference
+		uint64_t min = *std::min_element(values.begin(), values.end(), Less);
+		uint64_t max = *std::max_element(values.begin(), values.end(), Less);
+		int for_width = BitWidth(max - min);
+
+		// Delta（差は符号つきとして最小値・最大値を求める）
+		std::vector<uint64_t> deltas(n > 1 ? n - 1 : 0);
+		int64_t delta_min = 0, delta_max = 0;
+
+		for(size_t i = 1; i < n; i++)
+		{
+			int64_t delta = (int64_t)(values[i] - values[i - 1]);
+
+			delta_min = i == 1 ? delta : std::min(delta_min, delta);
+			delta_max = i == 1 ? delta : std::max(delta_max, delta);
+			deltas[i - 1] = values[i] - values[i - 1];
+		}
+
+		int delta_width = BitWidth((uint64_t)delta_max - (uint64_t)delta_min);
+
+		// RunLength
+		std::vector<uint64_t> runs, lengths;
+
+		for(size_t i = 0; i < n; i++)
+		{
+			if(i == 0 || values[i] != values[i - 1])
+			{
+				runs.push_back(values[i]);
+				lengths.push_back(0);
+			}
+			else
+			{
+				lengths.back()++;
+			}
+		}
+
+		int run_width = BitWidth(*std::max_element(lengths.begin(), lengths.end()));
+
+		// Dictionary
+		std::vector<uint64_t> dictionary(values);
+
+		std::sort(dictionary.begin(), dictionary.end());
+		dictionary.erase(std::unique(dictionary.begin(), dictionary.end()), dictionary.end());
+
+		int code_width = BitWidth(dictionary.size() - 1);
+
+		if(encoding == ColumnEncoding::Auto)
+		{
+			auto words = [](size_t count, int width) { return (count * width + 63) / 64; };
+			size_t for_size = words(n, for_width);
+			size_t delta_size = words(n - 1, delta_width);
+			size_t run_size = runs.size() + words(runs.size(), run_width);
+			size_t dictionary_size = dictionary.size() + words(n, code_width);
+			size_t best = std::min({for_size, delta_size, run_size, dictionary_size});
+
+			encoding = best == for_size ? ColumnEncoding::FrameOfReference
+				: best == delta_size ? ColumnEncoding::Delta
+				: best == run_size ? ColumnEncoding::RunLength : ColumnEncoding::Dictionary;
+		}
+
+		block.encoding = encoding;
+
+		switch(encoding)
+		{
+		case ColumnEncoding::Delta:
+			block.width = delta_width;
+			block.base = values[0];
+			block.reference = (uint64_t)delta_min;
+
+			for(auto & delta : deltas)
+			{
+				delta -= block.reference;
+			}
+
+			PackBits(words_, deltas.data(), deltas.size(), delta_width);
+			break;
+
+		case ColumnEncoding::RunLength:
+			block.width = run_width;
+			block.count = runs.size();
+			words_.insert(words_.end(), runs.begin(), runs.end());
+			PackBits(words_, lengths.data(), lengths.size(), run_width);
+			break;
+
+		case ColumnEncoding::Dictionary:
+		{
+			std::vector<uint64_t> codes(n);
+
+			for(size_t i = 0; i < n; i++)
+			{
+				codes[i] = (uint64_t)(std::lower_bound(dictionary.begin(), dictionary.end(), values[i]) - dictionary.begin());
+			}
+
+			block.width = code_width;
+			block.count = dictionary.size();
+			words_.insert(words_.end(), dictionary.begin(), dictionary.end());
+			PackBits(words_, codes.data(), n, code_width);
+			break;
+		}
+
+		default:
+		{
+			block.encoding = ColumnEncoding::FrameOfReference;
+			block.width = for_width;
+
+			std::vector<uint64_t> offsets(n);
+
+			for(size_t i = 0; i < n; i++)
+			{
+				offsets[i] = values[i] - min;
+			}
+
+			block.base = min;
+			PackBits(words_, offsets.data(), n, for_width);
+			break;
+		}
+		}
+
+		blocks_.push_back(block);
+		size_ += n;
+	}
+};
+
+#endif // __IZADORI_ENCODEDCOLUMN_H__
@@ -10,9 +10,17 @@
 #ifndef __IZADORI_ENUMERATOR_H__
 #define __IZADORI_ENUMERATOR_H__
 
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
 #include <tuple>
+#include <type_traits>
 #include <utility>
+#include <vector>
 
+#include "bitmask.h"
+#include "rowranges.h"
 #include "zipper.h"
 
 //-----------------------------------------------------------------------------------------
@@ -33,6 +41,12 @@ public:
 	class Iterator final
 	{
 	public:
+		using iterator_category = CommonIteratorCategory<Container>;
+		using value_type = std::tuple<int, GetValueType<Container>>;
+		using difference_type = std::ptrdiff_t;
+		using pointer = void;
+		using reference = std::tuple<int, GetReference<Container>>;
+
 		Iterator() : index_(0), step_(1){};
 
 		bool operator==(const Iterator & it) const
@@ -52,11 +66,94 @@ public:
 			return *this;
 		}
 
-		std::tuple<int, GetReference<Container>> operator*()
+		std::tuple<int, GetReference<Container>> operator*() const
 		{
 			return {index_, *iter_};
 		}
 
+		Iterator operator++(int)
+		{
+			Iterator it = *this;
+			++*this;
+			return it;
+		}
+
+		//---------------------------------------------------------------------------------
+		// 以下はランダムアクセス可能なコンテナの場合のみ使用できる
+		//---------------------------------------------------------------------------------
+		Iterator & operator--()
+		{
+			index_ -= step_;
+			--iter_;
+			return *this;
+		}
+
+		Iterator operator--(int)
+		{
+			Iterator it = *this;
+			--*this;
+			return it;
+		}
+
+		Iterator & operator+=(difference_type n)
+		{
+			index_ += (int)n * step_;
+			iter_ += n;
+			return *this;
+		}
+
+		Iterator & operator-=(difference_type n)
+		{
+			return *this += -n;
+		}
+
+		Iterator operator+(difference_type n) const
+		{
+			Iterator it = *this;
+			return it += n;
+		}
+
+		friend Iterator operator+(difference_type n, const Iterator & it)
+		{
+			return it + n;
+		}
+
+		Iterator operator-(difference_type n) const
+		{
+			Iterator it = *this;
+			return it -= n;
+		}
+
+		difference_type operator-(const Iterator & it) const
+		{
+			return this->iter_ - it.iter_;
+		}
+
+		auto operator[](difference_type n) const
+		{
+			return *(*this + n);
+		}
+
+		bool operator<(const Iterator & it) const
+		{
+			return this->iter_ < it.iter_;
+		}
+
+		bool operator>(const Iterator & it) const
+		{
+			return it < *this;
+		}
+
+		bool operator<=(const Iterator & it) const
+		{
+			return !(it < *this);
+		}
+
+		bool operator>=(const Iterator & it) const
+		{
+			return !(*this < it);
+		}
+
 	private:
 		int index_;
 		int step_;
@@ -75,8 +172,14 @@ public:
 		{
 			Iterator it;
 			it.iter_ = std::end(container);
-			it.index_ = (int)(std::distance(std::begin(container), std::end(container)) - 1) * step + initial_index;
+			it.index_ = initial_index;
 			it.step_ = step;
+
+			// 一度しか読めない範囲（SpscRingBuffer<>等）もあるため、ランダムアクセス可能な場合のみ終端のインデックスを求める
+			if constexpr(IsRandomAccess<Container>::value)
+			{
+				it.index_ += (int)(std::end(container) - std::begin(container)) * step;
+			}
 			return it;
 		}
 
@@ -95,8 +198,56 @@ public:
 		return Iterator::End(ref_, initial_index_, step_);
 	}
 
+	size_t size()
+	{
+		return GetRangeSize(ref_);
+	}
+
+	// n番目の要素をインデックスとともに返す（ランダムアクセス可能なコンテナではO(1)）
+	std::tuple<int, GetReference<Container>> operator[](size_t n)
+	{
+		static_assert(IsMultiPass<Container>::value, "Enumerator::operator[] cannot index a single-pass range");
+		return {initial_index_ + (int)n * step_, *std::next(std::begin(ref_), n)};
+	}
+
+	// [begin, end)番目の要素だけを列挙するEnumeratorを返す（インデックスは元のまま）
+	//   endはsize()に、beginはendに切り詰める
+	Enumerator<SubrangeType<Container>> Slice(size_t begin, size_t end)
+	{
+		size_t n = size();
+		end = end < n ? end : n;
+		begin = begin < end ? begin : end;
+
+		SubrangeType<Container> subrange = MakeSubrange(ref_, begin, end);
+		return Enumerator<SubrangeType<Container>>(subrange, initial_index_ + (int)begin * step_, step_);
+	}
+
+	// i番目の要素の前後で2つに分割する
+	std::pair<Enumerator<SubrangeType<Container>>, Enumerator<SubrangeType<Container>>> SplitAt(size_t i)
+	{
+		size_t n = size();
+		i = i < n ? i : n;
+		return {Slice(0, i), Slice(i, n)};
+	}
+
+	// 互いに重ならない連続したn個の部分に、要素数がなるべく均等になるように分割する
+	std::vector<Enumerator<SubrangeType<Container>>> Split(size_t n)
+	{
+		std::vector<Enumerator<SubrangeType<Container>>> parts;
+		size_t total = size();
+
+		parts.reserve(n);
+
+		for(size_t i = 0; i < n; i++)
+		{
+			parts.push_back(Slice(total * i / n, total * (i + 1) / n));
+		}
+
+		return parts;
+	}
+
 private:
-	Container & ref_;
+	ZipperStorage<Container> ref_;
 	int initial_index_;
 	int step_;
 };
@@ -123,6 +274,12 @@ public:
 	class Iterator final
 	{
 	public:
+		using iterator_category = typename Zipper<Containers...>::Iterator::iterator_category;
+		using value_type = std::tuple<int, typename Zipper<Containers...>::Iterator::value_type>;
+		using difference_type = std::ptrdiff_t;
+		using pointer = void;
+		using reference = std::tuple<int, typename Zipper<Containers...>::Iterator::reference>;
+
 		Iterator() : index_(0), step_(1){};
 
 		bool operator==(const Iterator & it) const
@@ -152,11 +309,94 @@ public:
 			return *this;
 		}
 
-		auto operator*()
+		auto operator*() const
 		{
 			return std::make_tuple(index_, *iter_);
 		};
 
+		Iterator operator++(int)
+		{
+			Iterator it = *this;
+			++*this;
+			return it;
+		}
+
+		//---------------------------------------------------------------------------------
+		// 以下はランダムアクセス可能なコンテナの場合のみ使用できる
+		//---------------------------------------------------------------------------------
+		Iterator & operator--()
+		{
+			index_ -= step_;
+			--iter_;
+			return *this;
+		}
+
+		Iterator operator--(int)
+		{
+			Iterator it = *this;
+			--*this;
+			return it;
+		}
+
+		Iterator & operator+=(difference_type n)
+		{
+			index_ += (int)n * step_;
+			iter_ += n;
+			return *this;
+		}
+
+		Iterator & operator-=(difference_type n)
+		{
+			return *this += -n;
+		}
+
+		Iterator operator+(difference_type n) const
+		{
+			Iterator it = *this;
+			return it += n;
+		}
+
+		friend Iterator operator+(difference_type n, const Iterator & it)
+		{
+			return it + n;
+		}
+
+		Iterator operator-(difference_type n) const
+		{
+			Iterator it = *this;
+			return it -= n;
+		}
+
+		difference_type operator-(const Iterator & it) const
+		{
+			return this->iter_ - it.iter_;
+		}
+
+		auto operator[](difference_type n) const
+		{
+			return *(*this + n);
+		}
+
+		bool operator<(const Iterator & it) const
+		{
+			return this->iter_ < it.iter_;
+		}
+
+		bool operator>(const Iterator & it) const
+		{
+			return it < *this;
+		}
+
+		bool operator<=(const Iterator & it) const
+		{
+			return !(it < *this);
+		}
+
+		bool operator>=(const Iterator & it) const
+		{
+			return !(*this < it);
+		}
+
 	private:
 		int index_;
 		int step_;
@@ -171,13 +411,20 @@ public:
 			return it;
 		}
 
-		static EndIterator End(Zipper<Containers...> & zipper, int initial_index, int step)
+		static auto End(Zipper<Containers...> & zipper, int initial_index, int step)
 		{
-			EndIterator it;
-			it.iter_ = zipper.end();
-			it.index_ = (int)(zipper.size() - 1) * step + initial_index;
-			it.step_ = step;
-			return it;
+			if constexpr(Zipper<Containers...>::random_access)
+			{
+				return Begin(zipper, initial_index, step) + (difference_type)zipper.size();
+			}
+			else
+			{
+				EndIterator it;
+				it.iter_ = zipper.end();
+				it.index_ = initial_index;
+				it.step_ = step;
+				return it;
+			}
 		}
 
 		friend Enumerator;
@@ -190,11 +437,59 @@ public:
 		return Iterator::Begin(zipper_, initial_index_, step_);
 	}
 
-	EndIterator end()
+	// ランダムアクセス可能な場合はIteratorを、それ以外はEndIteratorを返す
+	auto end()
 	{
 		return Iterator::End(zipper_, initial_index_, step_);
 	}
 
+	size_t size()
+	{
+		return zipper_.size();
+	}
+
+	// n番目の要素をインデックスとともに返す（ランダムアクセス可能なコンテナではO(1)）
+	auto operator[](size_t n)
+	{
+		return std::make_tuple(initial_index_ + (int)n * step_, zipper_[n]);
+	}
+
+	// [begin, end)番目の要素だけを列挙するEnumeratorを返す（インデックスは元のまま）
+	//   endはsize()に、beginはendに切り詰める
+	Enumerator<Zipper<SubrangeType<Containers>...>> Slice(size_t begin, size_t end)
+	{
+		size_t n = size();
+		end = end < n ? end : n;
+		begin = begin < end ? begin : end;
+
+		Zipper<SubrangeType<Containers>...> zipper = zipper_.Slice(begin, end);
+		return Enumerator<Zipper<SubrangeType<Containers>...>>(zipper, initial_index_ + (int)begin * step_, step_);
+	}
+
+	// i番目の要素の前後で2つに分割する
+	std::pair<Enumerator<Zipper<SubrangeType<Containers>...>>, Enumerator<Zipper<SubrangeType<Containers>...>>> SplitAt(size_t i)
+	{
+		size_t n = size();
+		i = i < n ? i : n;
+		return {Slice(0, i), Slice(i, n)};
+	}
+
+	// 互いに重ならない連続したn個の部分に、要素数がなるべく均等になるように分割する
+	std::vector<Enumerator<Zipper<SubrangeType<Containers>...>>> Split(size_t n)
+	{
+		std::vector<Enumerator<Zipper<SubrangeType<Containers>...>>> parts;
+		size_t total = size();
+
+		parts.reserve(n);
+
+		for(size_t i = 0; i < n; i++)
+		{
+			parts.push_back(Slice(total * i / n, total * (i + 1) / n));
+		}
+
+		return parts;
+	}
+
 private:
 	Zipper<Containers...> zipper_;
 	int initial_index_;
@@ -219,4 +514,341 @@ Enumerator<Zipper<Containers...>> Enumerate(Zipper<Containers...> && zipper, int
 	return Enumerator(zipper, initial_index, step);
 }
 
+//-----------------------------------------------------------------------------------------
+// IsEnumeratorクラス - Enumerator<>かどうかを判定する
+//-----------------------------------------------------------------------------------------
+template <typename T>
+struct IsEnumerator : std::false_type {};
+
+template <class Container>
+struct IsEnumerator<Enumerator<Container>> : std::true_type {};
+
+//-----------------------------------------------------------------------------------------
+// HasSizeクラス（Enumerator<>特殊化） - 一度しか読めない範囲のEnumerator<>は要素数を数えられない
+//-----------------------------------------------------------------------------------------
+template <class Container>
+struct HasSize<Enumerator<Container>> : IsCountable<Container> {};
+
+//-----------------------------------------------------------------------------------------
+// MaskCursorクラス - 選択ベクトル（昇順のインデックスのコンテナ）を順に走査する
+//   size以上のインデックスは、BitMaskと同様に読み飛ばす
+//-----------------------------------------------------------------------------------------
+template <class Indices>
+class MaskCursor final
+{
+public:
+	MaskCursor(const Indices & indices, size_t size, bool end)
+		: iter_(end ? End(indices, size) : std::begin(indices)) {}
+
+	// size未満のインデックスの終わりを返す
+	static GetIterator<const Indices> End(const Indices & indices, size_t size)
+	{
+		return std::lower_bound(std::begin(indices), std::end(indices), size, [](auto && index, size_t size) { return (size_t)index < size; });
+	}
+
+	bool operator==(const MaskCursor & cursor) const
+	{
+		return iter_ == cursor.iter_;
+	}
+
+	size_t Position() const
+	{
+		return (size_t)*iter_;
+	}
+
+	void Next()
+	{
+		++iter_;
+	}
+
+private:
+	GetIterator<const Indices> iter_;
+};
+
+//-----------------------------------------------------------------------------------------
+// MaskCursorクラス（BitMask特殊化） - 64ビットワードごとにtzcntで1のビットの位置を求める
+//-----------------------------------------------------------------------------------------
+template <>
+class MaskCursor<BitMask> final
+{
+public:
+	MaskCursor(const BitMask & mask, size_t size, bool end)
+		: mask_(mask.Truncate(size)), word_index_(0), word_(0), position_(0)
+	{
+		if(end || mask_.WordCount() == 0)
+		{
+			word_index_ = mask_.WordCount();
+			return;
+		}
+
+		word_ = mask_.Word(0);
+		Seek();
+	}
+
+	bool operator==(const MaskCursor & cursor) const
+	{
+		return word_index_ == cursor.word_index_ && word_ == cursor.word_;
+	}
+
+	size_t Position() const
+	{
+		return position_;
+	}
+
+	void Next()
+	{
+		word_ &= word_ - 1;
+		Seek();
+	}
+
+private:
+	BitMask mask_;
+	size_t word_index_;
+	uint64_t word_;
+	size_t position_;
+
+	// 0のワードを読み飛ばし、次の1のビットの位置に移動する
+	void Seek()
+	{
+		while(word_ == 0)
+		{
+			if(++word_index_ >= mask_.WordCount())
+			{
+				word_index_ = mask_.WordCount();
+				return;
+			}
+
+			word_ = mask_.Word(word_index_);
+		}
+
+		position_ = word_index_ * BitMask::word_bits + CountTrailingZeros(word_);
+	}
+};
+
+//-----------------------------------------------------------------------------------------
+// MaskCursorクラス（RowRanges特殊化） - 区間の終わりに達したら次の区間の先頭に移動する
+//-----------------------------------------------------------------------------------------
+template <>
+class MaskCursor<RowRanges> final
+{
+public:
+	MaskCursor(const RowRanges & ranges, size_t size, bool end)
+		: ranges_(&ranges), size_(size), index_(ranges.size()), position_(0)
+	{
+		if(!end && !ranges.empty() && ranges[0].first < size)
+		{
+			index_ = 0;
+			position_ = ranges[0].first;
+		}
+	}
+
+	bool operator==(const MaskCursor & cursor) const
+	{
+		return index_ == cursor.index_ && position_ == cursor.position_;
+	}
+
+	size_t Position() const
+	{
+		return position_;
+	}
+
+	void Next()
+	{
+		if(++position_ < (*ranges_)[index_].second && position_ < size_)
+		{
+			return;
+		}
+
+		if(++index_ < ranges_->size() && (*ranges_)[index_].first < size_)
+		{
+			position_ = (*ranges_)[index_].first;
+		}
+		else
+		{
+			index_ = ranges_->size();
+			position_ = 0;
+		}
+	}
+
+private:
+	const RowRanges * ranges_;
+	size_t size_;
+	size_t index_;
+	size_t position_;
+};
+
+//-----------------------------------------------------------------------------------------
+// SelectedEnumeratorクラス - マスクで選択された要素だけを元のインデックスとともに列挙する
+//   Rangeはコンテナへの参照またはZipper<>、Maskは選択ベクトル、BitMaskまたはRowRanges
+//   選択ベクトルは、Maskが参照型の場合は参照として、それ以外（一時オブジェクト）は値として保持する
+//-----------------------------------------------------------------------------------------
+template <class Range, class Mask>
+class SelectedEnumerator final
+{
+public:
+	using range_type = std::remove_reference_t<Range>;
+	using mask_type = std::remove_cv_t<std::remove_reference_t<Mask>>;
+
+	SelectedEnumerator() = delete;
+	SelectedEnumerator(Range range, Mask && mask, int initial_index = 0, int step = 1)
+		: range_(range), mask_(std::forward<Mask>(mask)), initial_index_(initial_index), step_(step) {}
+
+	class Iterator final
+	{
+	public:
+		bool operator==(const Iterator & it) const
+		{
+			return this->cursor_ == it.cursor_;
+		}
+
+		bool operator!=(const Iterator & it) const
+		{
+			return !(*this == it);
+		}
+
+		Iterator & operator++()
+		{
+			cursor_.Next();
+			return *this;
+		}
+
+		auto operator*()
+		{
+			size_t position = cursor_.Position();
+			return std::tuple<int, decltype(GetAt(*range_, position))>(initial_index_ + (int)position * step_, GetAt(*range_, position));
+		}
+
+	private:
+		Iterator(range_type * range, MaskCursor<mask_type> cursor, int initial_index, int step)
+			: range_(range), cursor_(cursor), initial_index_(initial_index), step_(step) {}
+
+		range_type * range_;
+		MaskCursor<mask_type> cursor_;
+		int initial_index_;
+		int step_;
+
+		friend SelectedEnumerator;
+	};
+
+	using iterator = Iterator;
+
+	Iterator begin()
+	{
+		return Iterator(&range_, MaskCursor<mask_type>(mask_, GetSize(), false), initial_index_, step_);
+	}
+
+	Iterator end()
+	{
+		return Iterator(&range_, MaskCursor<mask_type>(mask_, GetSize(), true), initial_index_, step_);
+	}
+
+	// 選択された全ての要素についてfunc(index, value)を呼び出す
+	//   BitMaskの場合、全ビットが1のワードは密な走査で、それ以外のワードはtzcntで処理する
+	//   RowRangesの場合、区間ごとに密な走査で処理する
+	template <typename Function>
+	void ForEach(Function && func)
+	{
+		if constexpr(std::is_same_v<mask_type, BitMask>)
+		{
+			BitMask mask = mask_.Truncate(GetSize());
+
+			for(size_t w = 0; w < mask.WordCount(); w++)
+			{
+				uint64_t word = mask.Word(w);
+				size_t base = w * BitMask::word_bits;
+
+				if(word == ~uint64_t(0))
+				{
+					for(size_t b = 0; b < BitMask::word_bits; b++)
+					{
+						func(initial_index_ + (int)(base + b) * step_, GetAt(range_, base + b));
+					}
+				}
+				else
+				{
+					for(; word != 0; word &= word - 1)
+					{
+						size_t position = base + CountTrailingZeros(word);
+						func(initial_index_ + (int)position * step_, GetAt(range_, position));
+					}
+				}
+			}
+		}
+		else if constexpr(std::is_same_v<mask_type, RowRanges>)
+		{
+			for(auto & range : mask_.Truncate(GetSize()))
+			{
+				for(size_t position = range.first; position < range.second; position++)
+				{
+					func(initial_index_ + (int)position * step_, GetAt(range_, position));
+				}
+			}
+		}
+		else
+		{
+			auto last = MaskCursor<mask_type>::End(mask_, GetSize());
+
+			for(auto it = std::begin(mask_); it != last; ++it)
+			{
+				func(initial_index_ + (int)*it * step_, GetAt(range_, (size_t)*it));
+			}
+		}
+	}
+
+private:
+	Range range_;
+	std::conditional_t<std::is_same_v<mask_type, BitMask> || std::is_same_v<mask_type, RowRanges> || !std::is_reference_v<Mask>, mask_type, const mask_type &> mask_;
+	int initial_index_;
+	int step_;
+
+	template <class Container>
+	static decltype(auto) GetAt(Container & container, size_t n)
+	{
+		static_assert(IsMultiPass<Container>::value, "EnumerateSelected cannot index a single-pass range");
+		return *std::next(std::begin(container), n);
+	}
+
+	template <class... Containers>
+	static auto GetAt(Zipper<Containers...> & zipper, size_t n)
+	{
+		return zipper[n];
+	}
+
+	size_t GetSize()
+	{
+		return GetSize(range_);
+	}
+
+	template <class Container>
+	static size_t GetSize(Container & container)
+	{
+		return GetRangeSize(container);
+	}
+
+	template <class... Containers>
+	static size_t GetSize(Zipper<Containers...> & zipper)
+	{
+		return zipper.size();
+	}
+};
+
+//-----------------------------------------------------------------------------------------
+// EnumerateSelected()関数 - maskで選択された要素だけを列挙する
+//   maskには昇順のインデックスのコンテナ（選択ベクトル）、BitMaskまたはRowRangesを指定する
+//-----------------------------------------------------------------------------------------
+template <class Container, class Mask>
+SelectedEnumerator<Container &, Mask> EnumerateSelected(Container & container, Mask && mask, int initial_index = 0, int step = 1)
+{
+	return SelectedEnumerator<Container &, Mask>(container, std::forward<Mask>(mask), initial_index, step);
+}
+
+//-----------------------------------------------------------------------------------------
+// EnumerateSelected()関数（Zipper<>版）
+//-----------------------------------------------------------------------------------------
+template <class... Containers, class Mask>
+SelectedEnumerator<Zipper<Containers...>, Mask> EnumerateSelected(Zipper<Containers...> && zipper, Mask && mask, int initial_index = 0, int step = 1)
+{
+	return SelectedEnumerator<Zipper<Containers...>, Mask>(zipper, std::forward<Mask>(mask), initial_index, step);
+}
+
 #endif // __IZADORI_ENUMERATOR_H__
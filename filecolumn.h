@@ -0,0 +1,434 @@
+﻿//
+// filecolumn.h
+//
+// Copyright (c) 2024 Izadori
+//
+// This software is released under the MIT License.
+// http://opensource.org/licenses/mit-license.php
+//
+
+#ifndef __IZADORI_FILECOLUMN_H__
+#define __IZADORI_FILECOLUMN_H__
+
+#include <algorithm>
+#include <cerrno>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "parallel.h"
+
+//-----------------------------------------------------------------------------------------
+// バイナリファイルの列を先読みしながらZip()できる範囲の実装（C++17対応のコンパイラが必要）
+//-----------------------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------------------
+// AsyncFileColumnクラス - T型の値をそのまま並べたバイナリファイルを、ブロック単位で先読みする
+//   blocks_in_flight個のスレッドがそれぞれ1つのバッファを持ち、i番目のスレッドが
+//   i, i + blocks_in_flight, ...番目のブロックをpread()で読み込む（読み込みと処理が重なる）
+//   Zip(col_a, col_b)のように他の列と組み合わせられる（先頭から一度だけ読める入力範囲で、
+//   size()で行数は分かるが、operator[]等で位置を指定して読むことはできない）
+//-----------------------------------------------------------------------------------------
+template <typename T>
+class AsyncFileColumn final
+{
+	static_assert(std::is_trivially_copyable_v<T>, "AsyncFileColumn<T> requires a trivially copyable type");
+
+public:
+	AsyncFileColumn(const std::string & path, size_t block_size = 1 << 20, size_t blocks_in_flight = 2)
+		: size_(0), block_rows_(std::max<size_t>(1, block_size / sizeof(T))), slots_(std::max<size_t>(2, blocks_in_flight)), consumed_(0), stop_(false), started_(false)
+	{
+		uint64_t bytes = Open(path);
+
+		size_ = (size_t)(bytes / sizeof(T));
+		block_count_ = (size_ + block_rows_ - 1) / block_rows_;
+
+		for(auto & slot : slots_)
+		{
+			slot.buffer.resize(block_rows_);
+		}
+	}
+
+	AsyncFileColumn(const AsyncFileColumn &) = delete;
+	AsyncFileColumn & operator=(const AsyncFileColumn &) = delete;
+
+	~AsyncFileColumn()
+	{
+		Stop();
+		Close();
+	}
+
+	//-------------------------------------------------------------------------------------
+	// Iteratorクラス - 入力イテレータ
+	//   ブロックの終わりまで進むと、そのバッファを読み込み用のスレッドに返して次のブロックを待つ
+	//-------------------------------------------------------------------------------------
+	class Iterator final
+	{
+	public:
+		using iterator_category = std::input_iterator_tag;
+		using value_type = T;
+		using difference_type = std::ptrdiff_t;
+		using pointer = const T *;
+		using reference = const T &;
+
+		Iterator() : column_(nullptr), row_(0), block_end_(0), current_(nullptr) {}
+
+		bool operator==(const Iterator & it) const
+		{
+			return row_ == it.row_;
+		}
+
+		bool operator!=(const Iterator & it) const
+		{
+			return row_ != it.row_;
+		}
+
+		Iterator & operator++()
+		{
+			current_++;
+
+			if(++row_ == block_end_ && row_ < column_->size_)
+			{
+				size_t block = row_ / column_->block_rows_;
+
+				column_->Release(block - 1);
+				current_ = column_->Acquire(block);
+				block_end_ = std::min(row_ + column_->block_rows_, column_->size_);
+			}
+
+			return *this;
+		}
+
+		Iterator operator++(int)
+		{
+			Iterator it = *this;
+			++*this;
+			return it;
+		}
+
+		const T & operator*() const
+		{
+			return *current_;
+		}
+
+		const T * operator->() const
+		{
+			return current_;
+		}
+
+	private:
+		AsyncFileColumn * column_;
+		size_t row_;
+		size_t block_end_;
+		const T * current_;
+
+		friend AsyncFileColumn;
+	};
+
+	using iterator = Iterator;
+
+	// 先頭から読み込みを始める（一度だけ呼び出せる。2回目以降はstd::logic_errorを送出する）
+	Iterator begin()
+	{
+		Iterator it;
+
+		if(started_)
+		{
+			throw std::logic_error("AsyncFileColumn: begin() can be called only once");
+		}
+
+		started_ = true;
+		Start();
+
+		it.column_ = this;
+
+		if(size_ > 0)
+		{
+			it.current_ = Acquire(0);
+			it.block_end_ = std::min(block_rows_, size_);
+		}
+
+		return it;
+	}
+
+	Iterator end()
+	{
+		Iterator it;
+		it.column_ = this;
+		it.row_ = size_;
+		return it;
+	}
+
+	size_t size() const
+	{
+		return size_;
+	}
+
+private:
+	struct Slot
+	{
+		std::vector<T, CacheAlignedAllocator<T>> buffer;
+		size_t block = SIZE_MAX;
+		int error = 0;
+	};
+
+	size_t size_;
+	size_t block_rows_;
+	size_t block_count_;
+	std::vector<Slot> slots_;
+	std::vector<std::thread> readers_;
+	std::mutex mutex_;
+	std::condition_variable cv_;
+	size_t consumed_;
+	bool stop_;
+	bool started_;
+
+#if defined(_WIN32)
+	HANDLE file_ = INVALID_HANDLE_VALUE;
+
+	uint64_t Open(const std::string & path)
+	{
+		file_ = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+
+		LARGE_INTEGER bytes;
+
+		if(file_ == INVALID_HANDLE_VALUE || !GetFileSizeEx(file_, &bytes))
+		{
+			int error = (int)GetLastError();
+			Close();
+			throw std::system_error(error, std::system_category(), path);
+		}
+
+		return (uint64_t)bytes.QuadPart;
+	}
+
+	void Close()
+	{
+		if(file_ != INVALID_HANDLE_VALUE)
+		{
+			CloseHandle(file_);
+			file_ = INVALID_HANDLE_VALUE;
+		}
+	}
+
+	// offsetからbytesバイトを読み込む（失敗した場合はエラーコードを返す）
+	int ReadAt(uint64_t offset, char * buffer, size_t bytes)
+	{
+		while(bytes > 0)
+		{
+			OVERLAPPED overlapped = {};
+			DWORD count = 0;
+
+			overlapped.Offset = (DWORD)offset;
+			overlapped.OffsetHigh = (DWORD)(offset >> 32);
+
+			if(!ReadFile(file_, buffer, (DWORD)std::min<size_t>(bytes, 1 << 30), &count, &overlapped))
+			{
+				return (int)GetLastError();
+			}
+
+			if(count == 0)
+			{
+				return ERROR_HANDLE_EOF;
+			}
+
+			offset += count;
+			buffer += count;
+			bytes -= count;
+		}
+
+		return 0;
+	}
+
+	static const std::error_category & ErrorCategory()
+	{
+		return std::system_category();
+	}
+#else
+	int file_ = -1;
+
+	uint64_t Open(const std::string & path)
+	{
+		struct stat status;
+
+		file_ = open(path.c_str(), O_RDONLY);
+
+		if(file_ < 0 || fstat(file_, &status) != 0)
+		{
+			int error = errno;
+			Close();
+			throw std::system_error(error, std::generic_category(), path);
+		}
+
+#if defined(POSIX_FADV_SEQUENTIAL)
+		posix_fadvise(file_, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+
+		return (uint64_t)status.st_size;
+	}
+
+	void Close()
+	{
+		if(file_ >= 0)
+		{
+			close(file_);
+			file_ = -1;
+		}
+	}
+
+	// offsetからbytesバイトを読み込む（失敗した場合はerrnoを返す）
+	int ReadAt(uint64_t offset, char * buffer, size_t bytes)
+	{
+		while(bytes > 0)
+		{
+			ssize_t count = pread(file_, buffer, bytes, (off_t)offset);
+
+			if(count < 0)
+			{
+				if(errno == EINTR)
+				{
+					continue;
+				}
+
+				return errno;
+			}
+
+			if(count == 0)
+			{
+				return EIO;
+			}
+
+			offset += (uint64_t)count;
+			buffer += count;
+			bytes -= (size_t)count;
+		}
+
+		return 0;
+	}
+
+	static const std::error_category & ErrorCategory()
+	{
+		return std::generic_category();
+	}
+#endif
+
+	void Start()
+	{
+		consumed_ = 0;
+		stop_ = false;
+
+		for(auto & slot : slots_)
+		{
+			slot.block = SIZE_MAX;
+			slot.error = 0;
+		}
+
+		for(size_t t = 0; t < slots_.size() && t < block_count_; t++)
+		{
+			readers_.emplace_back([this, t]() { Read(t); });
+		}
+	}
+
+	void Stop()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			stop_ = true;
+		}
+
+		cv_.notify_all();
+
+		for(auto & reader : readers_)
+		{
+			reader.join();
+		}
+
+		readers_.clear();
+	}
+
+	// t番目のスレッド - 前回のブロックが処理されてバッファが空くのを待ってから、次のブロックを読み込む
+	void Read(size_t t)
+	{
+		Slot & slot = slots_[t];
+
+		for(size_t block = t; block < block_count_; block += slots_.size())
+		{
+			{
+				std::unique_lock<std::mutex> lock(mutex_);
+				cv_.wait(lock, [this, block]() { return stop_ || block < consumed_ + slots_.size(); });
+
+				if(stop_)
+				{
+					return;
+				}
+			}
+
+			size_t rows = std::min(block_rows_, size_ - block * block_rows_);
+			int error = ReadAt((uint64_t)block * block_rows_ * sizeof(T), (char *)slot.buffer.data(), rows * sizeof(T));
+
+			{
+				std::lock_guard<std::mutex> lock(mutex_);
+				slot.block = block;
+				slot.error = error;
+			}
+
+			cv_.notify_all();
+
+			if(error != 0)
+			{
+				return;
+			}
+		}
+	}
+
+	// blockを読み込み終えるまで待って、その先頭へのポインタを返す
+	const T * Acquire(size_t block)
+	{
+		Slot & slot = slots_[block % slots_.size()];
+		std::unique_lock<std::mutex> lock(mutex_);
+
+		cv_.wait(lock, [&slot, block]() { return slot.block == block; });
+
+		if(slot.error != 0)
+		{
+			throw std::system_error(slot.error, ErrorCategory(), "AsyncFileColumn");
+		}
+
+		return slot.buffer.data();
+	}
+
+	// blockのバッファを読み込み用のスレッドに返す
+	void Release(size_t block)
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			consumed_ = block + 1;
+		}
+
+		cv_.notify_all();
+	}
+};
+
+#endif // __IZADORI_FILECOLUMN_H__
@@ -0,0 +1,304 @@
+﻿//
+// finder.h
+//
+// Copyright (c) 2024 Izadori
+//
+// This software is released under the MIT License.
+// http://opensource.org/licenses/mit-license.php
+//
+
+#ifndef __IZADORI_FINDER_H__
+#define __IZADORI_FINDER_H__
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstring>
+#include <iterator>
+#include <optional>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "enumerator.h"
+#include "parallel.h"
+#include "zipper.h"
+
+//-----------------------------------------------------------------------------------------
+// Zipper/Enumeratorに対するFindIf()/CountIf()/Mismatch()/Equal()関数の実装（C++17対応のコンパイラが必要）
+//   sourceはsize()とoperator[]を持つ範囲で、Zipper<>の場合は見つかった位置（無ければsize()）を、
+//   Enumerator<>の場合はEnumerate()のインデックス（無ければstd::nullopt）を返す
+//-----------------------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------------------
+// FindIfInRange関数 - [begin, end)でpredicate(row)が真となる最初の位置を返す（無ければend）
+//   一定数の行ごとに判定結果を分岐なしでまとめて求め、ブロック単位で早期に終了する
+//-----------------------------------------------------------------------------------------
+template <class Source, class Predicate>
+size_t FindIfInRange(Source & source, Predicate & predicate, size_t begin, size_t end)
+{
+	constexpr size_t block = 32;
+	size_t i = begin;
+
+	for(; i + block <= end; i += block)
+	{
+		unsigned char hits[block];
+		unsigned char any = 0;
+
+		for(size_t j = 0; j < block; j++)
+		{
+			hits[j] = predicate(source[i + j]) ? 1 : 0;
+			any |= hits[j];
+		}
+
+		if(any)
+		{
+			for(size_t j = 0; j < block; j++)
+			{
+				if(hits[j])
+				{
+					return i + j;
+				}
+			}
+		}
+	}
+
+	for(; i < end; i++)
+	{
+		if(predicate(source[i]))
+		{
+			return i;
+		}
+	}
+
+	return end;
+}
+
+//-----------------------------------------------------------------------------------------
+// ToFindResult関数 - 位置をFindIf()等の戻り値に変換する
+//-----------------------------------------------------------------------------------------
+template <class Source>
+auto ToFindResult(Source & source, size_t position)
+{
+	if constexpr(IsEnumerator<std::decay_t<Source>>::value)
+	{
+		return position < source.size() ? std::optional<int>(std::get<0>(source[position])) : std::nullopt;
+	}
+	else
+	{
+		return position;
+	}
+}
+
+//-----------------------------------------------------------------------------------------
+// FindIf関数 - predicate(row)が真となる最初の要素を探す
+//-----------------------------------------------------------------------------------------
+template <class Source, class Predicate>
+auto FindIf(Source && source, Predicate predicate)
+{
+	return ToFindResult(source, FindIfInRange(source, predicate, 0, source.size()));
+}
+
+//-----------------------------------------------------------------------------------------
+// ParallelFindPosition関数 - predicate(row)が真となる最初の位置を並列に探す（無ければsize()）
+//   範囲を小さなブロックに分け、各スレッドは共有のカウンタから先頭側のブロックを順に取り出して調べる
+//   見つかった最小の位置をアトミックに保持し、それより後ろのブロックは調べずに終了する
+//   stop_on_anyがtrueの場合は、どこかで見つかった時点で全てのスレッドが終了する
+//-----------------------------------------------------------------------------------------
+template <class Source, class Predicate>
+size_t ParallelFindPosition(Source & source, Predicate & predicate, unsigned int num_threads, bool stop_on_any)
+{
+	size_t size = source.size();
+	size_t threads = GetThreadCount(num_threads);
+	size_t block = std::max<size_t>(1024, size / (threads * 16));
+	size_t blocks = (size + block - 1) / block;
+	std::atomic<size_t> best(size);
+	std::atomic<size_t> next(0);
+
+	ParallelFor(threads, [&](size_t, size_t, unsigned int) {
+		while(true)
+		{
+			size_t b = next.fetch_add(1, std::memory_order_relaxed);
+			size_t begin = b * block;
+
+			if(b >= blocks || begin >= best.load(std::memory_order_relaxed))
+			{
+				return;
+			}
+
+			size_t end = std::min(begin + block, size);
+			size_t position = FindIfInRange(source, predicate, begin, end);
+
+			if(position < end)
+			{
+				size_t current = best.load(std::memory_order_relaxed);
+
+				while(position < current && !best.compare_exchange_weak(current, position, std::memory_order_relaxed))
+				{
+				}
+
+				if(stop_on_any)
+				{
+					return;
+				}
+			}
+			else if(stop_on_any && best.load(std::memory_order_relaxed) < size)
+			{
+				return;
+			}
+		}
+	}, num_threads);
+
+	return best.load();
+}
+
+//-----------------------------------------------------------------------------------------
+// ParallelFindIf関数 - FindIf()の並列版（結果はFindIf()と同じく最初の要素）
+//-----------------------------------------------------------------------------------------
+template <class Source, class Predicate>
+auto ParallelFindIf(Source && source, Predicate predicate, unsigned int num_threads = 0)
+{
+	return ToFindResult(source, ParallelFindPosition(source, predicate, num_threads, false));
+}
+
+//-----------------------------------------------------------------------------------------
+// ParallelAnyOf関数 - predicate(row)が真となる要素があればtrueを返す（見つかった時点で全スレッドが終了する）
+//-----------------------------------------------------------------------------------------
+template <class Source, class Predicate>
+bool ParallelAnyOf(Source && source, Predicate predicate, unsigned int num_threads = 0)
+{
+	return ParallelFindPosition(source, predicate, num_threads, true) < source.size();
+}
+
+//-----------------------------------------------------------------------------------------
+// CountIf関数 - predicate(row)が真となる要素の数を返す（分岐なしで数える）
+//-----------------------------------------------------------------------------------------
+template <class Source, class Predicate>
+size_t CountIf(Source && source, Predicate predicate, unsigned int num_threads = 1)
+{
+	PaddedAccumulators<size_t> counts(GetThreadCount(num_threads), 0);
+
+	ParallelFor(source.size(), [&](size_t begin, size_t end, unsigned int chunk) {
+		for(size_t i = begin; i < end; i++)
+		{
+			counts[chunk] += predicate(source[i]) ? 1 : 0;
+		}
+	}, num_threads);
+
+	return counts.Reduce();
+}
+
+//-----------------------------------------------------------------------------------------
+// MismatchPosition関数 - 2列のZipper<>で値が異なる最初の位置を返す（無ければsize()）
+//   両方の列が同じ整数型（文字型を含む）の連続したメモリ領域の場合は、memcmp()でブロック単位に比較する
+//-----------------------------------------------------------------------------------------
+template <class Container1, class Container2>
+size_t MismatchPosition(Zipper<Container1, Container2> & zipper)
+{
+	using value_type1 = std::remove_cv_t<GetValueType<Container1>>;
+	using value_type2 = std::remove_cv_t<GetValueType<Container2>>;
+
+	size_t size = zipper.size();
+
+	if constexpr(HasData<Container1>::value && HasData<Container2>::value && std::is_same_v<value_type1, value_type2> && std::is_integral_v<value_type1>)
+	{
+		constexpr size_t block = 256 / sizeof(value_type1);
+
+		auto containers = zipper.GetContainers();
+		const value_type1 * a = std::data(std::get<0>(containers));
+		const value_type1 * b = std::data(std::get<1>(containers));
+		size_t i = 0;
+
+		for(; i + block <= size; i += block)
+		{
+			if(std::memcmp(a + i, b + i, block * sizeof(value_type1)) != 0)
+			{
+				break;
+			}
+		}
+
+		for(; i < size; i++)
+		{
+			if(a[i] != b[i])
+			{
+				return i;
+			}
+		}
+
+		return size;
+	}
+	else
+	{
+		auto predicate = [](auto row) { return !(std::get<0>(row) == std::get<1>(row)); };
+		return FindIfInRange(zipper, predicate, 0, size);
+	}
+}
+
+//-----------------------------------------------------------------------------------------
+// Mismatch関数 - 2列の値が異なる最初の要素を探す
+//-----------------------------------------------------------------------------------------
+template <class Container1, class Container2>
+size_t Mismatch(Zipper<Container1, Container2> && zipper)
+{
+	return MismatchPosition(zipper);
+}
+
+template <class Container1, class Container2>
+size_t Mismatch(Zipper<Container1, Container2> & zipper)
+{
+	return MismatchPosition(zipper);
+}
+
+template <class Container1, class Container2>
+std::optional<int> Mismatch(Enumerator<Zipper<Container1, Container2>> && enumerator)
+{
+	return FindIf(enumerator, [](auto row) {
+		auto values = std::get<1>(row);
+		return !(std::get<0>(values) == std::get<1>(values));
+	});
+}
+
+//-----------------------------------------------------------------------------------------
+// Equal関数 - 2列の長さが等しく、全ての値が等しい場合にtrueを返す
+//   一度しか読めない列（SpscRingBuffer<>・AsyncFileColumn<>等）を含む場合は、
+//   両方の列を同時に1回だけ読み進めて比較する
+//-----------------------------------------------------------------------------------------
+template <class Container1, class Container2>
+bool Equal(Zipper<Container1, Container2> && zipper)
+{
+	auto containers = zipper.GetContainers();
+
+	if constexpr(IsMultiPass<Container1>::value && IsMultiPass<Container2>::value)
+	{
+		size_t size1 = GetRangeSize(std::get<0>(containers));
+		size_t size2 = GetRangeSize(std::get<1>(containers));
+
+		return size1 == size2 && MismatchPosition(zipper) == zipper.size();
+	}
+	else
+	{
+		auto it1 = std::begin(std::get<0>(containers));
+		auto end1 = std::end(std::get<0>(containers));
+		auto it2 = std::begin(std::get<1>(containers));
+		auto end2 = std::end(std::get<1>(containers));
+
+		for(; it1 != end1 && it2 != end2; ++it1, ++it2)
+		{
+			if(!(*it1 == *it2))
+			{
+				return false;
+			}
+		}
+
+		return it1 == end1 && it2 == end2;
+	}
+}
+
+template <class Container1, class Container2>
+bool Equal(Zipper<Container1, Container2> & zipper)
+{
+	return Equal(std::move(zipper));
+}
+
+#endif // __IZADORI_FINDER_H__
@@ -0,0 +1,132 @@
+﻿//
+// hasher.h
+//
+// Copyright (c) 2024 Izadori
+//
+// This software is released under the MIT License.
+// http://opensource.org/licenses/mit-license.php
+//
+
+#ifndef __IZADORI_HASHER_H__
+#define __IZADORI_HASHER_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "parallel.h"
+#include "zipper.h"
+
+//-----------------------------------------------------------------------------------------
+// Zipper<>の各行のハッシュ値を列ごとに計算するHashRows()関数の実装（C++17対応のコンパイラが必要）
+//-----------------------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------------------
+// MixHash/HashValue関数 - 1つの値のハッシュ値を返す
+//   整数・浮動小数点数はMurmurHash3の最終ミキサで計算し（ループがベクトル化されやすい）、
+//   それ以外の型はstd::hash<>を使う
+//-----------------------------------------------------------------------------------------
+inline uint64_t MixHash(uint64_t x)
+{
+	x ^= x >> 33;
+	x *= 0xff51afd7ed558ccdULL;
+	x ^= x >> 33;
+	x *= 0xc4ceb9fe1a85ec53ULL;
+	x ^= x >> 33;
+	return x;
+}
+
+template <typename T>
+uint64_t HashValue(const T & value)
+{
+	if constexpr(std::is_integral_v<T> || std::is_enum_v<T>)
+	{
+		return MixHash((uint64_t)value);
+	}
+	else if constexpr(std::is_floating_point_v<T> && sizeof(T) <= sizeof(uint64_t))
+	{
+		// 0.0と-0.0が同じハッシュ値になるようにする
+		T normalized = value == T(0) ? T(0) : value;
+		uint64_t bits = 0;
+		std::memcpy(&bits, &normalized, sizeof(T));
+		return MixHash(bits);
+	}
+	else
+	{
+		return (uint64_t)std::hash<T>()(value);
+	}
+}
+
+//-----------------------------------------------------------------------------------------
+// CombineHash関数 - これまでの行のハッシュ値に列の値のハッシュ値を合成する
+//-----------------------------------------------------------------------------------------
+inline uint64_t CombineHash(uint64_t seed, uint64_t hash)
+{
+	return (seed ^ hash) * 0x9e3779b97f4a7c15ULL + (seed >> 29);
+}
+
+//-----------------------------------------------------------------------------------------
+// HashColumn関数 - 1つの列の[begin, end)の値のハッシュ値をhashes[begin, end)に合成する
+//   参照がプロキシ（BitColumn::Reference等）の列も値の型に変換してからハッシュ値を求める
+//-----------------------------------------------------------------------------------------
+template <class Container>
+void HashColumn(Container & column, uint64_t * hashes, size_t begin, size_t end)
+{
+	using value_type = GetValueType<Container>;
+
+	auto it = std::next(std::begin(column), begin);
+
+	for(size_t i = begin; i < end; i++, ++it)
+	{
+		hashes[i] = CombineHash(hashes[i], HashValue<value_type>(*it));
+	}
+}
+
+//-----------------------------------------------------------------------------------------
+// HashRows関数 - 各行の全ての列の値を合成したハッシュ値をhashesに書き出す
+//   1行ずつタプルを経由せず、block行ごとに列を1つずつ処理する（列指向のハッシュ計算）
+//   hashesはresize()可能な連続したuint64_tのコンテナ
+//-----------------------------------------------------------------------------------------
+template <class... Containers, class Output>
+void HashRows(Zipper<Containers...> && zipper, Output & hashes, unsigned int num_threads = 1)
+{
+	constexpr size_t block = 1024;
+	constexpr uint64_t seed = 0x84222325cbf29ce4ULL;
+
+	size_t size = zipper.size();
+	auto columns = zipper.GetContainers();
+
+	hashes.resize(size);
+	uint64_t * data = std::data(hashes);
+
+	ParallelFor(size, [&columns, data](size_t begin, size_t end, unsigned int) {
+		for(size_t b = begin; b < end; b += block)
+		{
+			size_t e = b + block < end ? b + block : end;
+
+			for(size_t i = b; i < e; i++)
+			{
+				data[i] = seed;
+			}
+
+			std::apply([data, b, e](auto &... column) {
+				using swallow = std::initializer_list<int>;
+				(void)swallow{(HashColumn(column, data, b, e), 0)...};
+			}, columns);
+		}
+	}, num_threads, GetRowAlignment(Zip(hashes)));
+}
+
+template <class... Containers, class Output>
+void HashRows(Zipper<Containers...> & zipper, Output & hashes, unsigned int num_threads = 1)
+{
+	HashRows(std::move(zipper), hashes, num_threads);
+}
+
+#endif // __IZADORI_HASHER_H__
@@ -0,0 +1,201 @@
+﻿//
+// histogram.h
+//
+// Copyright (c) 2024 Izadori
+//
+// This software is released under the MIT License.
+// http://opensource.org/licenses/mit-license.php
+//
+
+#ifndef __IZADORI_HISTOGRAM_H__
+#define __IZADORI_HISTOGRAM_H__
+
+#include <algorithm>
+#include <cstddef>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "parallel.h"
+#include "zipper.h"
+
+//-----------------------------------------------------------------------------------------
+// Zipper<値, 重み>に対するHistogram()関数の実装（C++17対応のコンパイラが必要）
+//-----------------------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------------------
+// UniformBinsクラス - [min, max]を等間隔にcount個に分割したビン（ビンの位置は計算で求める）
+//-----------------------------------------------------------------------------------------
+class UniformBins final
+{
+public:
+	UniformBins() = delete;
+	UniformBins(double min, double max, size_t count)
+		: min_(min), max_(max), count_(count), scale_(0)
+	{
+		// min < maxでない場合（NaNを含む）やビンが無い場合は、ビンの位置を計算できない
+		if(!(min < max) || count == 0)
+		{
+			throw std::invalid_argument("UniformBins: requires min < max and count > 0");
+		}
+
+		scale_ = count / (max - min);
+	}
+
+	size_t size() const
+	{
+		return count_;
+	}
+
+	// 値が属するビンの番号を返す（範囲外やNaNの場合はsize()、maxは最後のビンに含める）
+	size_t Index(double value) const
+	{
+		double position = (value - min_) * scale_;
+
+		if(!(position >= 0 && value <= max_))
+		{
+			return count_;
+		}
+
+		size_t index = (size_t)position;
+		return index < count_ ? index : count_ - 1;
+	}
+
+private:
+	double min_;
+	double max_;
+	size_t count_;
+	double scale_;
+};
+
+//-----------------------------------------------------------------------------------------
+// EdgeBinsクラス - 昇順の境界値edgesで区切られたビン（ビンの位置は二分探索で求める）
+//-----------------------------------------------------------------------------------------
+class EdgeBins final
+{
+public:
+	EdgeBins() = delete;
+	EdgeBins(std::vector<double> edges) : edges_(std::move(edges)) {}
+
+	size_t size() const
+	{
+		return edges_.size() < 2 ? 0 : edges_.size() - 1;
+	}
+
+	// 値が属するビンの番号を返す（範囲外やNaNの場合はsize()、最後の境界値は最後のビンに含める）
+	size_t Index(double value) const
+	{
+		if(size() == 0 || !(value >= edges_.front() && value <= edges_.back()))
+		{
+			return size();
+		}
+
+		size_t index = (size_t)(std::upper_bound(edges_.begin(), edges_.end(), value) - edges_.begin()) - 1;
+		return index < size() ? index : size() - 1;
+	}
+
+private:
+	std::vector<double> edges_;
+};
+
+//-----------------------------------------------------------------------------------------
+// HistogramRowクラス - 行から値と重みを取り出す（Zipper<>以外の場合は重みを1とする）
+//-----------------------------------------------------------------------------------------
+template <class Source>
+struct HistogramRow
+{
+	template <class Row>
+	static double Value(const Row & row)
+	{
+		return (double)row;
+	}
+
+	template <class Row>
+	static size_t Weight(const Row &)
+	{
+		return 1;
+	}
+};
+
+template <class Values, class Weights>
+struct HistogramRow<Zipper<Values, Weights>>
+{
+	template <class Row>
+	static double Value(const Row & row)
+	{
+		return (double)std::get<0>(row);
+	}
+
+	template <class Row>
+	static GetValueType<Weights> Weight(const Row & row)
+	{
+		return std::get<1>(row);
+	}
+};
+
+//-----------------------------------------------------------------------------------------
+// Histogram関数 - 値をbinsで分類し、ビンごとの重みの合計を返す（範囲外の値は数えない）
+//   各区間（スレッド）は専用のヒストグラムを持ち、最後に合算する
+//   同じビンへの連続した加算がストア→ロードの依存で詰まらないよう、区間内でも
+//   sub_histograms個のヒストグラムに行を振り分けて数える
+//-----------------------------------------------------------------------------------------
+template <class Source, class Bins>
+auto Histogram(Source && source, const Bins & bins, unsigned int num_threads = 1)
+{
+	using row_type = HistogramRow<std::decay_t<Source>>;
+	using weight_type = std::decay_t<decltype(row_type::Weight(source[0]))>;
+
+	constexpr size_t sub_histograms = 4;
+
+	size_t bin_count = bins.size();
+	size_t stride = bin_count + 1;
+	std::vector<std::vector<weight_type>> locals(GetThreadCount(num_threads));
+
+	ParallelFor(source.size(), [&](size_t begin, size_t end, unsigned int chunk) {
+		// 範囲外の値はbin_count番目（捨てるためのビン）に数える
+		std::vector<weight_type> counts(stride * sub_histograms, weight_type());
+		size_t i = begin;
+
+		for(; i + sub_histograms <= end; i += sub_histograms)
+		{
+			for(size_t s = 0; s < sub_histograms; s++)
+			{
+				auto row = source[i + s];
+				counts[s * stride + bins.Index(row_type::Value(row))] += row_type::Weight(row);
+			}
+		}
+
+		for(; i < end; i++)
+		{
+			auto row = source[i];
+			counts[bins.Index(row_type::Value(row))] += row_type::Weight(row);
+		}
+
+		for(size_t s = 1; s < sub_histograms; s++)
+		{
+			for(size_t b = 0; b < bin_count; b++)
+			{
+				counts[b] += counts[s * stride + b];
+			}
+		}
+
+		counts.resize(bin_count);
+		locals[chunk] = std::move(counts);
+	}, num_threads);
+
+	std::vector<weight_type> result(bin_count, weight_type());
+
+	for(auto & local : locals)
+	{
+		for(size_t b = 0; b < local.size(); b++)
+		{
+			result[b] += local[b];
+		}
+	}
+
+	return result;
+}
+
+#endif // __IZADORI_HISTOGRAM_H__
@@ -0,0 +1,386 @@
+﻿//
+// locality.h
+//
+// Copyright (c) 2024 Izadori
+//
+// This software is released under the MIT License.
+// http://opensource.org/licenses/mit-license.php
+//
+
+#ifndef __IZADORI_LOCALITY_H__
+#define __IZADORI_LOCALITY_H__
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#if defined(__linux__)
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "parallel.h"
+#include "threadpool.h"
+#include "zipper.h"
+
+//-----------------------------------------------------------------------------------------
+// NUMAノードを意識したZipper<>の並列処理の実装（C++17対応のコンパイラが必要）
+//   Linuxではsysfsからノード構成を読み取り、move_pages(2)でページの置かれたノードを調べる
+//   （libnumaは不要）。ノードが1つの場合、それ以外の環境や取得に失敗した場合は、既定のThreadPoolを
+//   1つのノードとして使う
+//-----------------------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------------------
+// FirstTouchAllocatorクラス - 要素を値初期化しない（ゼロで埋めない）アロケータ
+//   resize()の時点ではページに触れないため、FirstTouch()で初期化したスレッドのノードにページが置かれる
+//-----------------------------------------------------------------------------------------
+template <typename T>
+class FirstTouchAllocator : public std::allocator<T>
+{
+public:
+	template <typename U>
+	struct rebind
+	{
+		using other = FirstTouchAllocator<U>;
+	};
+
+	FirstTouchAllocator() = default;
+
+	template <typename U>
+	FirstTouchAllocator(const FirstTouchAllocator<U> &) {}
+
+	template <typename U>
+	void construct(U * p)
+	{
+		::new((void *)p) U;
+	}
+
+	template <typename U, typename... Args>
+	void construct(U * p, Args &&... args)
+	{
+		::new((void *)p) U(std::forward<Args>(args)...);
+	}
+};
+
+//-----------------------------------------------------------------------------------------
+// NumaSchedulerクラス - NUMAノードごとに、そのノードのCPUに固定したThreadPoolを持つ
+//   ノードはCPUを持つものだけを0から順に番号付けし（以下、ノードの番号はこの番号）、
+//   OSのノードIDとの対応を保持する（ノードIDは連続しているとは限らない）
+//-----------------------------------------------------------------------------------------
+class NumaScheduler final
+{
+public:
+	using Topology = std::vector<std::pair<int, std::vector<int>>>;
+
+	NumaScheduler() : NumaScheduler(ReadTopology()) {}
+
+	// nodesは(OSのノードID, そのノードのCPUの一覧)の組のリスト
+	explicit NumaScheduler(const Topology & nodes)
+	{
+		for(auto & [id, cpus] : nodes)
+		{
+			if(id < 0 || cpus.empty())
+			{
+				continue;
+			}
+
+			if((size_t)id >= node_index_.size())
+			{
+				node_index_.resize(id + 1, -1);
+			}
+
+			node_index_[id] = (int)node_ids_.size();
+			node_ids_.push_back(id);
+		}
+
+		// ノードが1つの場合や構成を取得できない場合は、スレッドを増やさないように既定のThreadPoolを使う
+		if(node_ids_.size() <= 1)
+		{
+			pools_.push_back(&ThreadPool::GetDefault());
+			return;
+		}
+
+		for(auto & [id, cpus] : nodes)
+		{
+			if(id >= 0 && !cpus.empty())
+			{
+				owned_pools_.push_back(std::make_unique<ThreadPool>(cpus));
+				pools_.push_back(owned_pools_.back().get());
+			}
+		}
+	}
+
+	size_t NodeCount() const
+	{
+		return pools_.size();
+	}
+
+	ThreadPool & GetPool(size_t node)
+	{
+		return *pools_[node];
+	}
+
+	// OSのノードIDに対応するノードの番号を返す（対応するノードがない場合は-1）
+	int NodeIndex(int id) const
+	{
+		return id >= 0 && (size_t)id < node_index_.size() ? node_index_[id] : -1;
+	}
+
+	// addressのページが置かれているノードの番号を返す（不明な場合は-1）
+	int NodeOf(const void * address) const
+	{
+		return NodeIndex(QueryNodeId(address));
+	}
+
+	// [0, size)をノード数で均等に分割したときの、nodeが受け持つ範囲を返す
+	std::pair<size_t, size_t> GetNodeRange(size_t node, size_t size) const
+	{
+		size_t count = NodeCount();
+		return {size * node / count, size * (node + 1) / count};
+	}
+
+	// 各ノードのThreadPoolで、そのノードに割り当てた範囲を並列に処理する
+	// ranges[node]はノードが受け持つ[begin, end)の組のリストで、func(begin, end)を呼び出す
+	// 呼び出したスレッドはどのノードにも固定されていないため、タスクを実行せずに完了を待つ
+	template <typename Function>
+	void Run(const std::vector<std::vector<std::pair<size_t, size_t>>> & ranges, Function & func)
+	{
+		std::vector<std::unique_ptr<ThreadPool::TaskGroup>> groups;
+		std::exception_ptr error;
+
+		for(size_t node = 0; node < NodeCount(); node++)
+		{
+			groups.push_back(std::make_unique<ThreadPool::TaskGroup>());
+
+			ThreadPool & pool = GetPool(node);
+			unsigned int workers = (unsigned int)std::max<size_t>(1, pool.size());
+
+			for(auto & range : ranges[node])
+			{
+				size_t offset = range.first;
+				size_t length = range.second - range.first;
+
+				// ノードのワーカー上で分割することで、区間のタスクはそのノードの両端キューに積まれる
+				pool.Spawn(*groups.back(), [&pool, &func, offset, length, workers]() {
+					ParallelFor(pool, length, [&func, offset](size_t begin, size_t end, unsigned int) {
+						func(offset + begin, offset + end);
+					}, workers);
+				});
+			}
+		}
+
+		for(size_t node = 0; node < NodeCount(); node++)
+		{
+			try
+			{
+				GetPool(node).Wait(*groups[node]);
+			}
+			catch(...)
+			{
+				if(!error)
+				{
+					error = std::current_exception();
+				}
+			}
+		}
+
+		if(error)
+		{
+			std::rethrow_exception(error);
+		}
+	}
+
+	// 既定のNumaSchedulerを返す
+	static NumaScheduler & GetDefault()
+	{
+		static NumaScheduler scheduler;
+		return scheduler;
+	}
+
+private:
+	std::vector<ThreadPool *> pools_;
+	std::vector<std::unique_ptr<ThreadPool>> owned_pools_;
+	std::vector<int> node_ids_;
+	std::vector<int> node_index_;
+
+	// addressのページが置かれているOSのノードIDを返す（不明な場合は-1）
+	static int QueryNodeId(const void * address)
+	{
+#if defined(__linux__) && defined(SYS_move_pages)
+		long page_size = sysconf(_SC_PAGESIZE);
+		void * page = (void *)((uintptr_t)address & ~(uintptr_t)(page_size - 1));
+		int status = -1;
+
+		if(syscall(SYS_move_pages, 0, 1UL, &page, nullptr, &status, 0) == 0 && status >= 0)
+		{
+			return status;
+		}
+#else
+		(void)address;
+#endif
+		return -1;
+	}
+
+	// "0-3,8-11"の形式の番号のリスト（CPU・ノード）を読み取る
+	static std::vector<int> ParseCpuList(const std::string & text)
+	{
+		std::vector<int> cpus;
+		std::stringstream stream(text);
+		std::string item;
+
+		while(std::getline(stream, item, ','))
+		{
+			size_t dash = item.find('-');
+
+			try
+			{
+				int first = std::stoi(item.substr(0, dash));
+				int last = dash == std::string::npos ? first : std::stoi(item.substr(dash + 1));
+
+				for(int cpu = first; cpu <= last; cpu++)
+				{
+					cpus.push_back(cpu);
+				}
+			}
+			catch(const std::exception &)
+			{
+			}
+		}
+
+		return cpus;
+	}
+
+	// オンラインのノードごとのCPUの一覧を返す（取得できない場合は空）
+	//   ノードIDはオフラインのノードやメモリだけのノードで飛ぶことがあるため、onlineの一覧から読む
+	static Topology ReadTopology()
+	{
+		Topology nodes;
+
+#if defined(__linux__)
+		std::ifstream online("/sys/devices/system/node/online");
+		std::string text;
+
+		if(!online || !std::getline(online, text))
+		{
+			return nodes;
+		}
+
+		for(int id : ParseCpuList(text))
+		{
+			std::ifstream file("/sys/devices/system/node/node" + std::to_string(id) + "/cpulist");
+			std::string cpulist;
+
+			if(file && std::getline(file, cpulist))
+			{
+				nodes.emplace_back(id, ParseCpuList(cpulist));
+			}
+		}
+#endif
+
+		return nodes;
+	}
+};
+
+//-----------------------------------------------------------------------------------------
+// FirstTouch関数 - columnの先頭size個の要素をvalueで初期化する
+//   [0, size)をノード数で均等に分割し、各範囲をそのノードのワーカーが書き込むことで、
+//   ページを範囲ごとのノードに置く（FirstTouchAllocatorで確保した列と組み合わせて使う）
+//-----------------------------------------------------------------------------------------
+template <class Container, typename T>
+void FirstTouch(NumaScheduler & scheduler, Container & column, size_t size, const T & value)
+{
+	std::vector<std::vector<std::pair<size_t, size_t>>> ranges(scheduler.NodeCount());
+
+	for(size_t node = 0; node < scheduler.NodeCount(); node++)
+	{
+		ranges[node].push_back(scheduler.GetNodeRange(node, size));
+	}
+
+	auto first = std::begin(column);
+	auto func = [first, &value](size_t begin, size_t end) {
+		std::fill(std::next(first, begin), std::next(first, end), value);
+	};
+
+	scheduler.Run(ranges, func);
+}
+
+template <class Container, typename T>
+void FirstTouch(Container & column, size_t size, const T & value)
+{
+	FirstTouch(NumaScheduler::GetDefault(), column, size, value);
+}
+
+//-----------------------------------------------------------------------------------------
+// NumaParallelFor関数 - Zipper<>の行を、先頭の列のページが置かれたノードのワーカーで処理する
+//   [0, size)をノード数 × blocks_per_node個のブロックに分け、各ブロックの先頭の要素のページの
+//   ノードを調べて、同じノードの連続したブロックをまとめてそのノードに割り当てる
+//   ノードが不明なブロックは均等分割した場合のノードに割り当てる
+//   ブロックの境界は全ての列のキャッシュラインの境界に揃える
+//   先頭の列は連続したメモリ領域（std::data()）を持つ必要がある
+//-----------------------------------------------------------------------------------------
+template <class... Containers, typename Function>
+void NumaParallelFor(NumaScheduler & scheduler, Zipper<Containers...> & zipper, Function && func)
+{
+	constexpr size_t blocks_per_node = 16;
+
+	size_t size = zipper.size();
+	size_t nodes = scheduler.NodeCount();
+	size_t blocks = std::min(size, nodes * blocks_per_node);
+	auto * data = std::data(std::get<0>(zipper.GetContainers()));
+	std::vector<std::vector<std::pair<size_t, size_t>>> ranges(nodes);
+	RowAlignment alignment = GetRowAlignment(zipper);
+
+	for(size_t b = 0; b < blocks; b++)
+	{
+		size_t begin = alignment.Align(size * b / blocks, size);
+		size_t end = alignment.Align(size * (b + 1) / blocks, size);
+
+		if(begin == end)
+		{
+			continue;
+		}
+
+		int node = nodes > 1 ? scheduler.NodeOf(data + begin) : 0;
+
+		if(node < 0 || (size_t)node >= nodes)
+		{
+			node = (int)(b * nodes / blocks);
+		}
+
+		auto & list = ranges[node];
+
+		if(!list.empty() && list.back().second == begin)
+		{
+			list.back().second = end;
+		}
+		else
+		{
+			list.emplace_back(begin, end);
+		}
+	}
+
+	scheduler.Run(ranges, func);
+}
+
+template <class... Containers, typename Function>
+void NumaParallelFor(NumaScheduler & scheduler, Zipper<Containers...> && zipper, Function && func)
+{
+	NumaParallelFor(scheduler, zipper, std::forward<Function>(func));
+}
+
+template <class... Containers, typename Function>
+void NumaParallelFor(Zipper<Containers...> && zipper, Function && func)
+{
+	NumaParallelFor(NumaScheduler::GetDefault(), zipper, std::forward<Function>(func));
+}
+
+#endif // __IZADORI_LOCALITY_H__
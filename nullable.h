@@ -0,0 +1,431 @@
+﻿//
+// nullable.h
+//
+// Copyright (c) 2024 Izadori
+//
+// This software is released under the MIT License.
+// http://opensource.org/licenses/mit-license.php
+//
+
+#ifndef __IZADORI_NULLABLE_H__
+#define __IZADORI_NULLABLE_H__
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "bitcolumn.h"
+#include "zipper.h"
+
+//-----------------------------------------------------------------------------------------
+// 値の列と有効ビットマップ（validity bitmap）からなる、欠損値を持てる列の実装（C++17対応のコンパイラが必要）
+//-----------------------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------------------
+// Nullableクラス - 値の列Columnと、各行の値が有効かどうかを表すBitColumnの組
+//   Zip()で他の列と組み合わせると、各行はstd::optional<>のように使えるReferenceとなる
+//     for(auto [price, quantity] : Zip(prices, quantities)) { if(price) total += *price * quantity; }
+//   欠損値の行の値は不定（push_back(std::nullopt)ではvalue_type()）で、有効な行だけを
+//   列挙する場合はEnumerateSelected(column.Values(), column.Validity().AsMask())を使う
+//-----------------------------------------------------------------------------------------
+template <class Column>
+class Nullable final
+{
+public:
+	using value_type = GetValueType<Column>;
+
+	//-------------------------------------------------------------------------------------
+	// Referenceクラス - n行目の値と有効ビットへの参照
+	//-------------------------------------------------------------------------------------
+	class Reference final
+	{
+	public:
+		Reference(GetReference<Column> value, BitColumn::Reference valid) : value_(value), valid_(valid) {}
+		Reference(const Reference &) = default;
+
+		bool has_value() const
+		{
+			return valid_;
+		}
+
+		explicit operator bool() const
+		{
+			return valid_;
+		}
+
+		// 欠損値の場合はstd::bad_optional_accessを送出する
+		GetReference<Column> value() const
+		{
+			if(!valid_)
+			{
+				throw std::bad_optional_access();
+			}
+
+			return value_;
+		}
+
+		// 有効かどうかを確認せずに値を返す
+		GetReference<Column> operator*() const
+		{
+			return value_;
+		}
+
+		value_type value_or(const value_type & value) const
+		{
+			return valid_ ? value_type(value_) : value;
+		}
+
+		operator std::optional<value_type>() const
+		{
+			return valid_ ? std::optional<value_type>(value_) : std::nullopt;
+		}
+
+		Reference & operator=(const value_type & value)
+		{
+			value_ = value;
+			valid_ = true;
+			return *this;
+		}
+
+		Reference & operator=(std::nullopt_t)
+		{
+			valid_ = false;
+			return *this;
+		}
+
+		Reference & operator=(const std::optional<value_type> & value)
+		{
+			return value ? (*this = *value) : (*this = std::nullopt);
+		}
+
+		Reference & operator=(const Reference & reference)
+		{
+			value_ = reference.value_;
+			valid_ = (bool)reference.valid_;
+			return *this;
+		}
+
+	private:
+		GetReference<Column> value_;
+		BitColumn::Reference valid_;
+	};
+
+	//-------------------------------------------------------------------------------------
+	// Iteratorクラス - 値の列のイテレータと有効ビットのイテレータを同時に進める
+	//   値の列がランダムアクセス可能な場合はランダムアクセスイテレータとなる
+	//-------------------------------------------------------------------------------------
+	class Iterator final
+	{
+	public:
+		using iterator_category = CommonIteratorCategory<Column>;
+		using value_type = std::optional<GetValueType<Column>>;
+		using difference_type = std::ptrdiff_t;
+		using pointer = void;
+		using reference = Reference;
+
+		Iterator() = default;
+
+		bool operator==(const Iterator & it) const
+		{
+			return valid_ == it.valid_;
+		}
+
+		bool operator!=(const Iterator & it) const
+		{
+			return valid_ != it.valid_;
+		}
+
+		Iterator & operator++()
+		{
+			++value_;
+			++valid_;
+			return *this;
+		}
+
+		Iterator operator++(int)
+		{
+			Iterator it = *this;
+			++*this;
+			return it;
+		}
+
+		Reference operator*() const
+		{
+			return Reference(*value_, *valid_);
+		}
+
+		//---------------------------------------------------------------------------------
+		// 以下はランダムアクセス可能な列の場合のみ使用できる
+		//---------------------------------------------------------------------------------
+		Iterator & operator--()
+		{
+			--value_;
+			--valid_;
+			return *this;
+		}
+
+		Iterator operator--(int)
+		{
+			Iterator it = *this;
+			--*this;
+			return it;
+		}
+
+		Iterator & operator+=(difference_type n)
+		{
+			value_ += n;
+			valid_ += n;
+			return *this;
+		}
+
+		Iterator & operator-=(difference_type n)
+		{
+			return *this += -n;
+		}
+
+		Iterator operator+(difference_type n) const
+		{
+			Iterator it = *this;
+			return it += n;
+		}
+
+		friend Iterator operator+(difference_type n, const Iterator & it)
+		{
+			return it + n;
+		}
+
+		Iterator operator-(difference_type n) const
+		{
+			Iterator it = *this;
+			return it -= n;
+		}
+
+		difference_type operator-(const Iterator & it) const
+		{
+			return valid_ - it.valid_;
+		}
+
+		Reference operator[](difference_type n) const
+		{
+			return *(*this + n);
+		}
+
+		bool operator<(const Iterator & it) const
+		{
+			return valid_ < it.valid_;
+		}
+
+		bool operator>(const Iterator & it) const
+		{
+			return it < *this;
+		}
+
+		bool operator<=(const Iterator & it) const
+		{
+			return !(it < *this);
+		}
+
+		bool operator>=(const Iterator & it) const
+		{
+			return !(*this < it);
+		}
+
+	private:
+		GetIterator<Column> value_;
+		BitColumn::Iterator valid_;
+
+		Iterator(GetIterator<Column> value, BitColumn::Iterator valid) : value_(value), valid_(valid) {}
+
+		friend Nullable;
+	};
+
+	using iterator = Iterator;
+
+	Nullable() = default;
+
+	// 値の列と有効ビットから作る（長さは短い方に合わせる）
+	Nullable(Column values, BitColumn validity) : values_(std::move(values)), validity_(std::move(validity))
+	{
+		size_t size = std::min(GetRangeSize(values_), validity_.size());
+
+		values_.resize(size);
+		validity_.resize(size);
+	}
+
+	// std::optional<>の値のコンテナから作る
+	template <class Container, typename = std::enable_if_t<std::is_convertible_v<GetValueType<const Container>, std::optional<value_type>>>>
+	explicit Nullable(const Container & values)
+	{
+		for(auto && value : values)
+		{
+			push_back(std::optional<value_type>(value));
+		}
+	}
+
+	Iterator begin()
+	{
+		return Iterator(std::begin(values_), validity_.begin());
+	}
+
+	Iterator end()
+	{
+		return Iterator(std::end(values_), validity_.end());
+	}
+
+	size_t size() const
+	{
+		return validity_.size();
+	}
+
+	void reserve(size_t size)
+	{
+		values_.reserve(size);
+		validity_.reserve(size);
+	}
+
+	// 追加した行は欠損値とする
+	void resize(size_t size)
+	{
+		values_.resize(size);
+		validity_.resize(size);
+	}
+
+	void push_back(const value_type & value)
+	{
+		values_.push_back(value);
+		validity_.push_back(true);
+	}
+
+	void push_back(std::nullopt_t)
+	{
+		values_.push_back(value_type());
+		validity_.push_back(false);
+	}
+
+	void push_back(const std::optional<value_type> & value)
+	{
+		value ? push_back(*value) : push_back(std::nullopt);
+	}
+
+	Reference operator[](size_t n)
+	{
+		return Reference(*std::next(std::begin(values_), n), validity_[n]);
+	}
+
+	Column & Values()
+	{
+		return values_;
+	}
+
+	BitColumn & Validity()
+	{
+		return validity_;
+	}
+
+	// 欠損値の行数を返す
+	size_t NullCount() const
+	{
+		return validity_.size() - validity_.Count();
+	}
+
+private:
+	Column values_;
+	BitColumn validity_;
+};
+
+//-----------------------------------------------------------------------------------------
+// MaskedReduce関数 - 有効な行の値だけをopで集約する（有効な行がない場合はinitを返す）
+//   64行ずつ有効ビットのワードを調べ、全て有効なワードはそのまま、一部が有効なワードは
+//   欠損値をidentityに置き換えて分岐なしで集約する（コンパイラがベクトル化できる）
+//-----------------------------------------------------------------------------------------
+template <class Column, typename T, typename BinaryOp>
+T MaskedReduce(Nullable<Column> & column, T init, T identity, BinaryOp op)
+{
+	static_assert(IsRandomAccess<Column>::value, "MaskedReduce requires a random access column");
+
+	auto values = std::begin(column.Values());
+	const uint64_t * words = column.Validity().Words();
+	size_t size = column.size();
+	T result = init;
+
+	for(size_t w = 0; w * BitColumn::word_bits < size; w++)
+	{
+		uint64_t word = words[w];
+		size_t base = w * BitColumn::word_bits;
+		size_t count = std::min(BitColumn::word_bits, size - base);
+
+		if(word == 0)
+		{
+			continue;
+		}
+
+		T partial = identity;
+
+		if(count == BitColumn::word_bits && word == ~uint64_t(0))
+		{
+			for(size_t b = 0; b < BitColumn::word_bits; b++)
+			{
+				partial = op(partial, (T)values[base + b]);
+			}
+		}
+		else
+		{
+			for(size_t b = 0; b < count; b++)
+			{
+				partial = op(partial, ((word >> b) & 1) ? (T)values[base + b] : identity);
+			}
+		}
+
+		result = op(result, partial);
+	}
+
+	return result;
+}
+
+//-----------------------------------------------------------------------------------------
+// MaskedSum関数・MaskedMin関数・MaskedMax関数 - 有効な行の値の合計・最小値・最大値
+//   MaskedMin()/MaskedMax()は、有効な行がない場合にstd::nulloptを返す
+//-----------------------------------------------------------------------------------------
+template <class Column>
+auto MaskedSum(Nullable<Column> & column)
+{
+	using T = GetValueType<Column>;
+	return MaskedReduce(column, T(), T(), std::plus<T>());
+}
+
+template <class Column>
+std::optional<GetValueType<Column>> MaskedMin(Nullable<Column> & column)
+{
+	using T = GetValueType<Column>;
+
+	if(column.NullCount() == column.size())
+	{
+		return std::nullopt;
+	}
+
+	T identity = std::numeric_limits<T>::has_infinity ? std::numeric_limits<T>::infinity() : std::numeric_limits<T>::max();
+	return MaskedReduce(column, identity, identity, [](T a, T b) { return b < a ? b : a; });
+}
+
+template <class Column>
+std::optional<GetValueType<Column>> MaskedMax(Nullable<Column> & column)
+{
+	using T = GetValueType<Column>;
+
+	if(column.NullCount() == column.size())
+	{
+		return std::nullopt;
+	}
+
+	T identity = std::numeric_limits<T>::has_infinity ? -std::numeric_limits<T>::infinity() : std::numeric_limits<T>::lowest();
+	return MaskedReduce(column, identity, identity, [](T a, T b) { return a < b ? b : a; });
+}
+
+#endif // __IZADORI_NULLABLE_H__
@@ -0,0 +1,528 @@
+﻿//
+// parallel.h
+//
+// Copyright (c) 2024 Izadori
+//
+// This software is released under the MIT License.
+// http://opensource.org/licenses/mit-license.php
+//
+
+#ifndef __IZADORI_PARALLEL_H__
+#define __IZADORI_PARALLEL_H__
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <exception>
+#include <initializer_list>
+#include <new>
+#include <numeric>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "threadpool.h"
+#include "zipper.h"
+
+//-----------------------------------------------------------------------------------------
+// Zipper/Enumeratorを並列処理するための補助関数（C++17対応のコンパイラが必要）
+//-----------------------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------------------
+// GetThreadCount関数 - 0が指定された場合はハードウェアのスレッド数を返す
+//-----------------------------------------------------------------------------------------
+inline unsigned int GetThreadCount(unsigned int num_threads = 0)
+{
+	if(num_threads == 0)
+	{
+		num_threads = std::thread::hardware_concurrency();
+	}
+
+	return num_threads == 0 ? 1 : num_threads;
+}
+
+//-----------------------------------------------------------------------------------------
+// キャッシュラインの大きさ（バイト）
+//-----------------------------------------------------------------------------------------
+constexpr size_t cache_line_size = 64;
+
+//-----------------------------------------------------------------------------------------
+// CacheLinePaddedクラス - 値を1つのキャッシュラインに単独で配置する
+//-----------------------------------------------------------------------------------------
+template <typename T>
+struct alignas(cache_line_size) CacheLinePadded
+{
+	T value;
+};
+
+//-----------------------------------------------------------------------------------------
+// PaddedAccumulatorsクラス - 区間（スレッド）ごとの集計値を、互いに別のキャッシュラインに保持する
+//   並列ループの中で頻繁に更新しても偽共有（false sharing）が発生しない
+//-----------------------------------------------------------------------------------------
+template <typename T>
+class PaddedAccumulators final
+{
+public:
+	PaddedAccumulators(size_t count, const T & init = T()) : values_(count, CacheLinePadded<T>{init}) {}
+
+	T & operator[](size_t n)
+	{
+		return values_[n].value;
+	}
+
+	size_t size() const
+	{
+		return values_.size();
+	}
+
+	// 全ての集計値をopで集約する
+	template <class BinaryOp = std::plus<>>
+	T Reduce(T init = T(), BinaryOp op = BinaryOp()) const
+	{
+		for(auto & value : values_)
+		{
+			init = op(init, value.value);
+		}
+
+		return init;
+	}
+
+private:
+	std::vector<CacheLinePadded<T>> values_;
+};
+
+//-----------------------------------------------------------------------------------------
+// RowAlignmentクラス - 全ての列でキャッシュラインの境界となる行（phase + period * k）を表す
+//   並列ループの区間の境界をこの行に揃えると、隣り合う区間が同じキャッシュラインに書き込まない
+//-----------------------------------------------------------------------------------------
+struct RowAlignment
+{
+	size_t phase = 0;
+	size_t period = 1;
+
+	// row以上で最も近い境界の行を返す（sizeを超えない）
+	size_t Align(size_t row, size_t size) const
+	{
+		if(row >= size)
+		{
+			return size;
+		}
+
+		if(row <= phase)
+		{
+			return std::min(row == 0 ? 0 : phase, size);
+		}
+
+		size_t aligned = phase + (row - phase + period - 1) / period * period;
+		return std::min(aligned, size);
+	}
+
+	// 先頭からoffset行目を0行目とした場合の境界を返す
+	RowAlignment Offset(size_t offset) const
+	{
+		return RowAlignment{(phase + period - offset % period) % period, period};
+	}
+};
+
+//-----------------------------------------------------------------------------------------
+// HasPackedRowsクラス - 1つのワードに複数の行を詰めて格納する列（BitColumn等）かどうかを判定する
+//   そのような列はbits_per_rowとワードの配列を返すWords()を持つ
+//-----------------------------------------------------------------------------------------
+template <typename T, typename = void>
+struct HasPackedRows : std::false_type {};
+
+template <typename T>
+struct HasPackedRows<T, std::void_t<decltype(T::bits_per_row), decltype(std::declval<T &>().Words())>> : std::true_type {};
+
+//-----------------------------------------------------------------------------------------
+// HasValidityクラス - 値の列と有効ビットマップの組（Nullable<>等）かどうかを判定する
+//   そのような列はValues()とValidity()を持ち、1行の読み書きが両方の列に及ぶ
+//-----------------------------------------------------------------------------------------
+template <typename T, typename = void>
+struct HasValidity : std::false_type {};
+
+template <typename T>
+struct HasValidity<T, std::void_t<decltype(std::declval<T &>().Values()), decltype(std::declval<T &>().Validity())>> : std::true_type {};
+
+//-----------------------------------------------------------------------------------------
+// RowAlignmentColumnクラス - GetRowAlignment()が境界を調べる列（メモリ領域）
+//-----------------------------------------------------------------------------------------
+struct RowAlignmentColumn
+{
+	uintptr_t address;
+	size_t bits;       // 1行のビット数
+	size_t word_bits;  // 複数の行を詰めて格納するワードのビット数（詰めない列は0）
+};
+
+// containerの境界を調べるメモリ領域をcolumnsに追加する（Nullable<>等は値の列と有効ビットマップの両方）
+template <class Container>
+void AddRowAlignmentColumns(std::vector<RowAlignmentColumn> & columns, Container & container)
+{
+	if constexpr(HasValidity<Container>::value)
+	{
+		AddRowAlignmentColumns(columns, container.Values());
+		AddRowAlignmentColumns(columns, container.Validity());
+	}
+	else if constexpr(HasPackedRows<Container>::value)
+	{
+		columns.push_back({(uintptr_t)container.Words(), Container::bits_per_row, sizeof(*container.Words()) * 8});
+	}
+	else if constexpr(HasData<Container>::value)
+	{
+		columns.push_back({(uintptr_t)std::data(container), sizeof(*std::data(container)) * 8, 0});
+	}
+}
+
+//-----------------------------------------------------------------------------------------
+// GetRowAlignment関数 - Zipper<>の連続したメモリ領域を持つ列から、区間の境界にすべき行を求める
+//   各列の境界の周期（512 / gcd(512, 要素のビット数)行）の最小公倍数を周期とし、
+//   その中で先頭のアドレスを考慮して最も多くの列がキャッシュラインの先頭となる行を選ぶ
+//   （全ての列を64バイト境界に確保しておけば、全ての列で境界が揃う）
+//   1つのワードに複数の行を詰める列がある場合は、それらの全ての列でワードの先頭となる行だけから選ぶ
+//   （ワードの途中で区間を分けると、隣り合う区間が同じワードを読み書きして値が失われる）
+//-----------------------------------------------------------------------------------------
+template <class... Containers>
+RowAlignment GetRowAlignment(Zipper<Containers...> & zipper)
+{
+	constexpr size_t cache_line_bits = cache_line_size * 8;
+	std::vector<RowAlignmentColumn> columns;
+
+	std::apply([&columns](auto &... containers) {
+		using swallow = std::initializer_list<int>;
+		(void)swallow{(AddRowAlignmentColumns(columns, containers), 0)...};
+	}, zipper.GetContainers());
+
+	RowAlignment alignment;
+
+	for(auto & column : columns)
+	{
+		alignment.period = std::lcm(alignment.period, cache_line_bits / std::gcd(cache_line_bits, column.bits));
+	}
+
+	// ワードの配列はワード境界に確保されるため、0行目は常に全ての列でワードの先頭となる
+	size_t best = 0;
+
+	for(size_t row = 0; row < alignment.period && !columns.empty(); row++)
+	{
+		size_t count = 0;
+		bool word_boundary = true;
+
+		for(auto & column : columns)
+		{
+			size_t bit = column.address * 8 + row * column.bits;
+
+			if(column.word_bits != 0 && bit % column.word_bits != 0)
+			{
+				word_boundary = false;
+				break;
+			}
+
+			count += bit % cache_line_bits == 0 ? 1 : 0;
+		}
+
+		if(word_boundary && (row == 0 || count > best))
+		{
+			best = count;
+			alignment.phase = row;
+		}
+	}
+
+	return alignment;
+}
+
+template <class... Containers>
+RowAlignment GetRowAlignment(Zipper<Containers...> && zipper)
+{
+	return GetRowAlignment(zipper);
+}
+
+//-----------------------------------------------------------------------------------------
+// CacheAlignedAllocatorクラス - 64バイト境界に領域を確保するアロケータ
+//-----------------------------------------------------------------------------------------
+template <typename T>
+class CacheAlignedAllocator
+{
+public:
+	using value_type = T;
+
+	CacheAlignedAllocator() = default;
+
+	template <typename U>
+	CacheAlignedAllocator(const CacheAlignedAllocator<U> &) {}
+
+	T * allocate(size_t n)
+	{
+		return (T *)::operator new(n * sizeof(T), std::align_val_t(std::max(cache_line_size, alignof(T))));
+	}
+
+	void deallocate(T * p, size_t)
+	{
+		::operator delete(p, std::align_val_t(std::max(cache_line_size, alignof(T))));
+	}
+
+	template <typename U>
+	bool operator==(const CacheAlignedAllocator<U> &) const
+	{
+		return true;
+	}
+
+	template <typename U>
+	bool operator!=(const CacheAlignedAllocator<U> &) const
+	{
+		return false;
+	}
+};
+
+//-----------------------------------------------------------------------------------------
+// ParallelFor関数 - [0, size)を連続した区間に分割し、func(begin, end, chunk_index)を並列に呼び出す
+//   chunk_indexは区間の番号で、番号の小さい区間ほど前の範囲を受け持つ
+//   区間はpoolのタスクとして実行され、呼び出したスレッドも最初の区間と残りのタスクを実行する
+//   （ParallelFor()の中でParallelFor()を呼び出してもスレッドは増えない）
+//   alignmentを指定した場合、区間の境界をその行に揃える（境界によっては空の区間もある）
+//-----------------------------------------------------------------------------------------
+template <typename Function>
+void ParallelFor(ThreadPool & pool, size_t size, Function && func, unsigned int num_threads = 0, RowAlignment alignment = RowAlignment())
+{
+	size_t count = std::min<size_t>(GetThreadCount(num_threads), size);
+
+	if(count <= 1)
+	{
+		func(size_t(0), size, 0u);
+		return;
+	}
+
+	size_t chunk = (size + count - 1) / count;
+	ThreadPool::TaskGroup group;
+	std::exception_ptr error;
+
+	for(size_t t = 1; t < count; t++)
+	{
+		size_t begin = alignment.Align(chunk * t, size);
+		size_t end = alignment.Align(chunk * (t + 1), size);
+
+		pool.Spawn(group, [&func, begin, end, t]() { func(begin, end, (unsigned int)t); });
+	}
+
+	try
+	{
+		func(size_t(0), alignment.Align(chunk, size), 0u);
+	}
+	catch(...)
+	{
+		error = std::current_exception();
+	}
+
+	// 区間0で例外が発生した場合も、他のタスクがfuncを参照しなくなるまで待つ
+	try
+	{
+		pool.Sync(group);
+	}
+	catch(...)
+	{
+		if(!error)
+		{
+			error = std::current_exception();
+		}
+	}
+
+	if(error)
+	{
+		std::rethrow_exception(error);
+	}
+}
+
+//-----------------------------------------------------------------------------------------
+// ParallelFor関数（既定のスレッドプール版）
+//-----------------------------------------------------------------------------------------
+template <typename Function>
+void ParallelFor(size_t size, Function && func, unsigned int num_threads = 0, RowAlignment alignment = RowAlignment())
+{
+	ParallelFor(ThreadPool::GetDefault(), size, std::forward<Function>(func), num_threads, alignment);
+}
+
+//-----------------------------------------------------------------------------------------
+// GrainSizeクラス - 並列ループの1要素あたりの処理時間の推定値（ナノ秒）を保持する
+//-----------------------------------------------------------------------------------------
+class GrainSize final
+{
+public:
+	// 推定処理時間がこれ未満のループは並列化しない
+	static constexpr double serial_cutoff = 50000.0;
+
+	// 1つのタスクが処理する時間の目安
+	static constexpr double task_duration = 20000.0;
+
+	// 最初に処理時間を測定する時間の目安
+	static constexpr double sampling_duration = 5000.0;
+
+	GrainSize() : nanoseconds_(0.0) {}
+
+	bool IsMeasured() const
+	{
+		return nanoseconds_.load(std::memory_order_relaxed) > 0.0;
+	}
+
+	double Get() const
+	{
+		return nanoseconds_.load(std::memory_order_relaxed);
+	}
+
+	// 新しい測定値を反映する（以前の値がある場合は平均を取る）
+	void Update(double nanoseconds)
+	{
+		double previous = nanoseconds_.load(std::memory_order_relaxed);
+		nanoseconds_.store(previous > 0.0 ? (previous + nanoseconds) / 2 : nanoseconds, std::memory_order_relaxed);
+	}
+
+	// 呼び出し箇所（関数オブジェクトの型）ごとのGrainSizeを返す
+	template <typename Function>
+	static GrainSize & GetInstance()
+	{
+		static GrainSize grain;
+		return grain;
+	}
+
+private:
+	std::atomic<double> nanoseconds_;
+};
+
+//-----------------------------------------------------------------------------------------
+// SpawnRange関数 - [begin, end)をgrain個以下になるまで二分し、後半をタスクとして追加する（分割位置はalignmentに揃える）
+//-----------------------------------------------------------------------------------------
+template <typename Function>
+void SpawnRange(ThreadPool & pool, ThreadPool::TaskGroup & group, size_t begin, size_t end, size_t grain, const RowAlignment & alignment, Function & func)
+{
+	while(end - begin > grain)
+	{
+		size_t middle = alignment.Align(begin + (end - begin) / 2, end);
+
+		if(middle >= end)
+		{
+			break;
+		}
+
+		pool.Spawn(group, [&pool, &group, middle, end, grain, &alignment, &func]() { SpawnRange(pool, group, middle, end, grain, alignment, func); });
+		end = middle;
+	}
+
+	func(begin, end);
+}
+
+//-----------------------------------------------------------------------------------------
+// AdaptiveParallelFor関数 - 区間の大きさ（粒度）を自動的に決めてfunc(begin, end)を並列に呼び出す
+//   1. 処理時間が未知の場合は先頭から要素数を倍々に増やしながら逐次処理し、1要素あたりの時間を測る
+//   2. 残りの推定処理時間がserial_cutoff未満であれば逐次処理する
+//   3. それ以外は1つのタスクの処理時間がtask_durationとなるように区間を分割し、並列に処理する
+//   測定結果はgrainに保持され、次回以降の呼び出しでは測定を省略する
+//-----------------------------------------------------------------------------------------
+template <typename Function>
+void AdaptiveParallelFor(ThreadPool & pool, size_t size, Function && func, GrainSize & grain, RowAlignment alignment = RowAlignment())
+{
+	using clock = std::chrono::steady_clock;
+
+	size_t begin = 0;
+
+	if(!grain.IsMeasured())
+	{
+		size_t count = 16;
+		auto start = clock::now();
+		double elapsed = 0.0;
+
+		while(begin < size && elapsed < GrainSize::sampling_duration)
+		{
+			size_t end = alignment.Align(begin + count, size);
+			func(begin, end);
+			begin = end;
+			count *= 2;
+			elapsed = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - start).count();
+		}
+
+		if(begin > 0)
+		{
+			grain.Update(std::max(elapsed, 1.0) / begin);
+		}
+	}
+
+	size_t rest = size - begin;
+
+	if(rest == 0)
+	{
+		return;
+	}
+
+	if(rest * grain.Get() < GrainSize::serial_cutoff || pool.size() == 0)
+	{
+		auto start = clock::now();
+		func(begin, size);
+		grain.Update(std::max((double)std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - start).count(), 1.0) / rest);
+		return;
+	}
+
+	size_t chunk = std::max<size_t>(1, (size_t)(GrainSize::task_duration / grain.Get()));
+	ThreadPool::TaskGroup group;
+	std::exception_ptr error;
+
+	try
+	{
+		SpawnRange(pool, group, begin, size, chunk, alignment, func);
+	}
+	catch(...)
+	{
+		error = std::current_exception();
+	}
+
+	try
+	{
+		pool.Sync(group);
+	}
+	catch(...)
+	{
+		if(!error)
+		{
+			error = std::current_exception();
+		}
+	}
+
+	if(error)
+	{
+		std::rethrow_exception(error);
+	}
+}
+
+//-----------------------------------------------------------------------------------------
+// AdaptiveParallelFor関数（既定のスレッドプール版） - 測定結果はfuncの型（ラムダ式）ごとに保持する
+//-----------------------------------------------------------------------------------------
+template <typename Function>
+void AdaptiveParallelFor(size_t size, Function && func)
+{
+	AdaptiveParallelFor(ThreadPool::GetDefault(), size, func, GrainSize::GetInstance<std::decay_t<Function>>());
+}
+
+//-----------------------------------------------------------------------------------------
+// ParallelForEach関数 - Zipper/Enumerator等の全ての要素についてfunc(row)を並列に呼び出す
+//   rangeはsize()とoperator[]を持つ範囲で、粒度はAdaptiveParallelFor()で自動的に決める
+//   rangeがZipper<>の場合、区間の境界を全ての列のキャッシュラインの境界に揃える
+//-----------------------------------------------------------------------------------------
+template <class Range, typename Function>
+void ParallelForEach(Range && range, Function && func)
+{
+	RowAlignment alignment;
+
+	if constexpr(IsZipper<std::decay_t<Range>>::value)
+	{
+		alignment = GetRowAlignment(range);
+	}
+
+	AdaptiveParallelFor(ThreadPool::GetDefault(), range.size(), [&range, &func](size_t begin, size_t end) {
+		for(size_t i = begin; i < end; i++)
+		{
+			func(range[i]);
+		}
+	}, GrainSize::GetInstance<std::pair<std::decay_t<Range>, std::decay_t<Function>>>(), alignment);
+}
+
+#endif // __IZADORI_PARALLEL_H__
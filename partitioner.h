@@ -0,0 +1,137 @@
+﻿//
+// partitioner.h
+//
+// Copyright (c) 2024 Izadori
+//
+// This software is released under the MIT License.
+// http://opensource.org/licenses/mit-license.php
+//
+
+#ifndef __IZADORI_PARTITIONER_H__
+#define __IZADORI_PARTITIONER_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <stdexcept>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "collector.h"
+#include "parallel.h"
+#include "zipper.h"
+
+//-----------------------------------------------------------------------------------------
+// Zipper<キー, ペイロード...>の行をキーのハッシュ値で分割するPartition()関数の実装（C++17対応のコンパイラが必要）
+//-----------------------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------------------
+// Partition関数 - 入力の各行をhash(key) % num_partsの番号のパーティションに振り分け、
+//   パーティション番号順に連続させて出力先の末尾に書き出す
+//   戻り値はパーティションpが出力先の[offsets[p], offsets[p + 1])を占めることを表すnum_parts + 1個の位置
+//   入力・出力ともにランダムアクセス可能なコンテナのZipperである必要がある
+//   num_partsが0の場合はstd::invalid_argumentを送出する
+//
+//   1. 区間ごとに各行のパーティション番号とその個数（ヒストグラム）を求める
+//   2. ヒストグラムから区間ごと・パーティションごとの書き込み開始位置を求める
+//   3. 区間ごとに行をパーティション別の小さなバッファ（キャッシュに収まる大きさ）に溜め、
+//      バッファが一杯になった時点で出力先へまとめて書き出す
+//-----------------------------------------------------------------------------------------
+template <class... Inputs, class Hash, class... Outputs>
+std::vector<size_t> Partition(Zipper<Inputs...> && input, size_t num_parts, Hash hash, Zipper<Outputs...> && output, unsigned int num_threads = 1)
+{
+	using row_type = std::tuple<GetValueType<Inputs>...>;
+
+	constexpr size_t buffer_rows = 16;
+
+	// パーティション番号はuint32_tで保持する
+	if(num_parts == 0 || num_parts > std::numeric_limits<uint32_t>::max())
+	{
+		throw std::invalid_argument("Partition: num_parts must be in [1, 2^32 - 1]");
+	}
+
+	size_t offset = output.size();
+	size_t size = input.size();
+	size_t chunks = GetThreadCount(num_threads);
+	bool power_of_two = (num_parts & (num_parts - 1)) == 0;
+	std::vector<uint32_t> parts(size);
+	std::vector<std::vector<size_t>> positions(chunks, std::vector<size_t>(num_parts, 0));
+
+	ParallelFor(size, [&](size_t begin, size_t end, unsigned int chunk) {
+		auto & histogram = positions[chunk];
+
+		for(size_t i = begin; i < end; i++)
+		{
+			size_t h = hash(std::get<0>(input[i]));
+			uint32_t part = (uint32_t)(power_of_two ? h & (num_parts - 1) : h % num_parts);
+			parts[i] = part;
+			histogram[part]++;
+		}
+	}, num_threads);
+
+	// パーティション順、その中では区間順に並ぶよう、ヒストグラムを書き込み開始位置に置き換える
+	std::vector<size_t> offsets(num_parts + 1, offset);
+	size_t position = offset;
+
+	for(size_t p = 0; p < num_parts; p++)
+	{
+		offsets[p] = position;
+
+		for(size_t c = 0; c < chunks; c++)
+		{
+			size_t count = positions[c][p];
+			positions[c][p] = position;
+			position += count;
+		}
+	}
+
+	offsets[num_parts] = position;
+
+	ResizeColumns(output, offset + size);
+
+	ParallelFor(size, [&](size_t begin, size_t end, unsigned int chunk) {
+		auto & next = positions[chunk];
+		std::vector<row_type> buffer(num_parts * buffer_rows);
+		std::vector<size_t> filled(num_parts, 0);
+
+		auto flush = [&](size_t part) {
+			row_type * rows = &buffer[part * buffer_rows];
+
+			for(size_t r = 0; r < filled[part]; r++)
+			{
+				output[next[part] + r] = rows[r];
+			}
+
+			next[part] += filled[part];
+			filled[part] = 0;
+		};
+
+		for(size_t i = begin; i < end; i++)
+		{
+			size_t part = parts[i];
+			buffer[part * buffer_rows + filled[part]] = input[i];
+
+			if(++filled[part] == buffer_rows)
+			{
+				flush(part);
+			}
+		}
+
+		for(size_t p = 0; p < num_parts; p++)
+		{
+			flush(p);
+		}
+	}, num_threads);
+
+	return offsets;
+}
+
+template <class... Inputs, class Hash, class... Outputs>
+std::vector<size_t> Partition(Zipper<Inputs...> & input, size_t num_parts, Hash hash, Zipper<Outputs...> & output, unsigned int num_threads = 1)
+{
+	return Partition(std::move(input), num_parts, hash, std::move(output), num_threads);
+}
+
+#endif // __IZADORI_PARTITIONER_H__
@@ -0,0 +1,519 @@
+﻿//
+// pipeline.h
+//
+// Copyright (c) 2024 Izadori
+//
+// This software is released under the MIT License.
+// http://opensource.org/licenses/mit-license.php
+//
+
+#ifndef __IZADORI_PIPELINE_H__
+#define __IZADORI_PIPELINE_H__
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "parallel.h"
+
+//-----------------------------------------------------------------------------------------
+// Zipper/Enumeratorをパイプライン並列で処理するクラス・関数の実装（C++17対応のコンパイラが必要）
+//   Pipeline(Enumerate(a, b)) | Stage(decode, 2) | Stage(encode) | Sink(write);
+//-----------------------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------------------
+// BoundedQueueクラス - 容量が固定のロックフリーなMPMCキュー
+//   各セルの通し番号で空き・使用中を判定する（Dmitry Vyukov, "Bounded MPMC queue"）
+//-----------------------------------------------------------------------------------------
+template <typename T>
+class BoundedQueue final
+{
+public:
+	BoundedQueue(size_t capacity) : enqueue_(0), dequeue_(0), closed_(false)
+	{
+		size_t size = 2;
+
+		while(size < capacity)
+		{
+			size <<= 1;
+		}
+
+		mask_ = size - 1;
+		cells_ = std::make_unique<Cell[]>(size);
+
+		for(size_t i = 0; i < size; i++)
+		{
+			cells_[i].sequence.store(i, std::memory_order_relaxed);
+		}
+	}
+
+	BoundedQueue(const BoundedQueue &) = delete;
+	BoundedQueue & operator=(const BoundedQueue &) = delete;
+
+	// 末尾に追加する（満杯の場合はfalseを返す）
+	bool TryPush(T && item)
+	{
+		size_t pos = enqueue_.load(std::memory_order_relaxed);
+		Cell * cell;
+
+		for(;;)
+		{
+			cell = &cells_[pos & mask_];
+			size_t sequence = cell->sequence.load(std::memory_order_acquire);
+			intptr_t diff = (intptr_t)sequence - (intptr_t)pos;
+
+			if(diff == 0)
+			{
+				if(enqueue_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+				{
+					break;
+				}
+			}
+			else if(diff < 0)
+			{
+				return false;
+			}
+			else
+			{
+				pos = enqueue_.load(std::memory_order_relaxed);
+			}
+		}
+
+		cell->item = std::move(item);
+		cell->sequence.store(pos + 1, std::memory_order_release);
+
+		return true;
+	}
+
+	// 先頭から取り出す（空の場合はfalseを返す）
+	bool TryPop(T & item)
+	{
+		size_t pos = dequeue_.load(std::memory_order_relaxed);
+		Cell * cell;
+
+		for(;;)
+		{
+			cell = &cells_[pos & mask_];
+			size_t sequence = cell->sequence.load(std::memory_order_acquire);
+			intptr_t diff = (intptr_t)sequence - (intptr_t)(pos + 1);
+
+			if(diff == 0)
+			{
+				if(dequeue_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+				{
+					break;
+				}
+			}
+			else if(diff < 0)
+			{
+				return false;
+			}
+			else
+			{
+				pos = dequeue_.load(std::memory_order_relaxed);
+			}
+		}
+
+		item = std::move(cell->item);
+		cell->sequence.store(pos + mask_ + 1, std::memory_order_release);
+
+		return true;
+	}
+
+	// これ以上追加しないことを通知する（追加済みの要素は取り出せる）
+	void Close()
+	{
+		closed_.store(true, std::memory_order_release);
+	}
+
+	bool IsClosed() const
+	{
+		return closed_.load(std::memory_order_acquire);
+	}
+
+	size_t capacity() const
+	{
+		return mask_ + 1;
+	}
+
+private:
+	struct Cell
+	{
+		std::atomic<size_t> sequence;
+		T item;
+	};
+
+	size_t mask_;
+	std::unique_ptr<Cell[]> cells_;
+	alignas(cache_line_size) std::atomic<size_t> enqueue_;
+	alignas(cache_line_size) std::atomic<size_t> dequeue_;
+	alignas(cache_line_size) std::atomic<bool> closed_;
+};
+
+//-----------------------------------------------------------------------------------------
+// PipelineBatchクラス - ステージ間で受け渡す要素のまとまり
+//   sequenceは元の範囲での順番（先頭からbatch_size個ずつの通し番号）
+//-----------------------------------------------------------------------------------------
+template <typename T>
+struct PipelineBatch
+{
+	size_t sequence = 0;
+	std::vector<T> items;
+};
+
+//-----------------------------------------------------------------------------------------
+// PipelineStageクラス・PipelineSinkクラス - Stage()/Sink()で生成する
+//-----------------------------------------------------------------------------------------
+template <typename Function>
+struct PipelineStage
+{
+	Function func;
+	unsigned int num_threads;
+};
+
+template <typename Function>
+struct PipelineSink
+{
+	Function func;
+};
+
+//-----------------------------------------------------------------------------------------
+// Stage関数 - 各要素についてfunc(item)を呼び出し、その戻り値を次のステージに渡す
+//   num_threads個のスレッドで処理する（0の場合はハードウェアのスレッド数）
+//-----------------------------------------------------------------------------------------
+template <typename Function>
+auto Stage(Function && func, unsigned int num_threads = 1)
+{
+	return PipelineStage<std::decay_t<Function>>{std::forward<Function>(func), GetThreadCount(num_threads)};
+}
+
+//-----------------------------------------------------------------------------------------
+// Sink関数 - 最後のステージの戻り値について、元の範囲の順番でfunc(item)を呼び出す
+//   funcはパイプラインを実行したスレッドで呼び出される
+//-----------------------------------------------------------------------------------------
+template <typename Function>
+auto Sink(Function && func)
+{
+	return PipelineSink<std::decay_t<Function>>{std::forward<Function>(func)};
+}
+
+//-----------------------------------------------------------------------------------------
+// PipelineBuilderクラス - Pipeline()で生成し、operator|でステージを追加する
+//   Sink()を追加した時点で実行し、全ての要素を処理するまで待つ
+//-----------------------------------------------------------------------------------------
+template <class Range, class... Stages>
+class PipelineBuilder final
+{
+public:
+	PipelineBuilder(Range && range, size_t batch_size, size_t queue_capacity, std::tuple<Stages...> && stages)
+		: range_(std::forward<Range>(range)), batch_size_(batch_size == 0 ? 1 : batch_size), queue_capacity_(queue_capacity), stages_(std::move(stages))
+	{
+	}
+
+	template <typename Function>
+	auto operator|(PipelineStage<Function> && stage) &&
+	{
+		return PipelineBuilder<Range, Stages..., PipelineStage<Function>>(
+			std::forward<Range>(range_), batch_size_, queue_capacity_, std::tuple_cat(std::move(stages_), std::make_tuple(std::move(stage)))
+		);
+	}
+
+	template <typename Function>
+	void operator|(PipelineSink<Function> && sink) &&
+	{
+		Run(sink.func);
+	}
+
+private:
+	using Reference = decltype(*std::begin(std::declval<Range &>()));
+
+	// 参照を返す範囲はポインタを、値（std::tuple<>等）を返す範囲はその値を受け渡す
+	using SourceItem = std::conditional_t<std::is_reference_v<Reference>, std::remove_reference_t<Reference> *, Reference>;
+
+	// 全てのスレッドで共有する状態
+	struct Context
+	{
+		std::atomic<bool> abort{false};
+		std::mutex mutex;
+		std::exception_ptr exception;
+
+		void Fail(std::exception_ptr e)
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+
+			if(!exception)
+			{
+				exception = e;
+			}
+
+			abort.store(true, std::memory_order_release);
+		}
+
+		bool IsAborted() const
+		{
+			return abort.load(std::memory_order_acquire);
+		}
+	};
+
+	std::conditional_t<std::is_lvalue_reference_v<Range>, Range, std::decay_t<Range>> range_;
+	size_t batch_size_;
+	size_t queue_capacity_;
+	std::tuple<Stages...> stages_;
+
+	template <bool IsSource, typename T>
+	static decltype(auto) Get(T & item)
+	{
+		if constexpr(IsSource && std::is_reference_v<Reference>)
+		{
+			return *item;
+		}
+		else
+		{
+			return (item);
+		}
+	}
+
+	// 空きができるまで待ってから追加する（中断された場合はfalseを返す）
+	template <typename T>
+	static bool Push(Context & context, BoundedQueue<PipelineBatch<T>> & queue, PipelineBatch<T> && batch)
+	{
+		while(!queue.TryPush(std::move(batch)))
+		{
+			if(context.IsAborted())
+			{
+				return false;
+			}
+
+			std::this_thread::yield();
+		}
+
+		return true;
+	}
+
+	// 要素が追加されるまで待ってから取り出す（終端に達したか、中断された場合はfalseを返す）
+	template <typename T>
+	static bool Pop(Context & context, BoundedQueue<PipelineBatch<T>> & queue, PipelineBatch<T> & batch)
+	{
+		for(;;)
+		{
+			if(queue.TryPop(batch))
+			{
+				return true;
+			}
+
+			if(context.IsAborted())
+			{
+				return false;
+			}
+
+			if(queue.IsClosed())
+			{
+				// Close()より前に追加された要素が残っていないか確認する
+				return queue.TryPop(batch);
+			}
+
+			std::this_thread::yield();
+		}
+	}
+
+	// 範囲の要素をbatch_size個ずつ区切って最初のキューに追加する
+	void ReadSource(Context & context, BoundedQueue<PipelineBatch<SourceItem>> & output)
+	{
+		try
+		{
+			PipelineBatch<SourceItem> batch;
+			auto end = std::end(range_);
+
+			batch.items.reserve(batch_size_);
+
+			for(auto it = std::begin(range_); it != end; ++it)
+			{
+				if constexpr(std::is_reference_v<Reference>)
+				{
+					batch.items.push_back(&*it);
+				}
+				else
+				{
+					batch.items.push_back(*it);
+				}
+
+				if(batch.items.size() == batch_size_)
+				{
+					size_t sequence = batch.sequence;
+
+					if(!Push(context, output, std::move(batch)))
+					{
+						break;
+					}
+
+					batch = PipelineBatch<SourceItem>();
+					batch.sequence = sequence + 1;
+					batch.items.reserve(batch_size_);
+				}
+			}
+
+			if(!batch.items.empty())
+			{
+				Push(context, output, std::move(batch));
+			}
+		}
+		catch(...)
+		{
+			context.Fail(std::current_exception());
+		}
+
+		output.Close();
+	}
+
+	// I番目のステージを起動し、次のステージ（またはSink）を処理する
+	template <size_t I, typename T, typename SinkFunction>
+	void RunStage(Context & context, BoundedQueue<PipelineBatch<T>> & input, SinkFunction & sink)
+	{
+		if constexpr(I == sizeof...(Stages))
+		{
+			// 順番が前後したまとまりは、それより前のまとまりが届くまで保留する
+			std::map<size_t, PipelineBatch<T>> pending;
+			PipelineBatch<T> batch;
+			size_t next = 0;
+
+			try
+			{
+				while(Pop(context, input, batch))
+				{
+					pending.emplace(batch.sequence, std::move(batch));
+
+					for(auto it = pending.begin(); it != pending.end() && it->first == next; it = pending.erase(it), next++)
+					{
+						for(auto & item : it->second.items)
+						{
+							sink(Get<I == 0>(item));
+						}
+					}
+				}
+			}
+			catch(...)
+			{
+				context.Fail(std::current_exception());
+			}
+		}
+		else
+		{
+			auto & stage = std::get<I>(stages_);
+			using Function = decltype(stage.func);
+			using Result = std::decay_t<decltype(stage.func(Get<I == 0>(std::declval<T &>())))>;
+
+			BoundedQueue<PipelineBatch<Result>> output(queue_capacity_);
+			std::atomic<unsigned int> remaining(stage.num_threads);
+			std::vector<std::thread> threads;
+
+			auto worker = [this, &context, &input, &output, &remaining, &stage]() {
+				try
+				{
+					Function func(stage.func);
+					PipelineBatch<T> batch;
+
+					while(Pop(context, input, batch))
+					{
+						PipelineBatch<Result> result;
+
+						result.sequence = batch.sequence;
+						result.items.reserve(batch.items.size());
+
+						for(auto & item : batch.items)
+						{
+							result.items.push_back(func(Get<I == 0>(item)));
+						}
+
+						if(!Push(context, output, std::move(result)))
+						{
+							break;
+						}
+					}
+				}
+				catch(...)
+				{
+					context.Fail(std::current_exception());
+				}
+
+				// 最後に終了したスレッドが次のステージに終端を通知する
+				if(remaining.fetch_sub(1, std::memory_order_acq_rel) == 1)
+				{
+					output.Close();
+				}
+			};
+
+			try
+			{
+				for(unsigned int t = 0; t < stage.num_threads; t++)
+				{
+					threads.emplace_back(worker);
+				}
+			}
+			catch(...)
+			{
+				context.Fail(std::current_exception());
+				remaining.fetch_sub(stage.num_threads - (unsigned int)threads.size(), std::memory_order_acq_rel);
+			}
+
+			RunStage<I + 1>(context, output, sink);
+
+			for(auto & thread : threads)
+			{
+				thread.join();
+			}
+		}
+	}
+
+	template <typename SinkFunction>
+	void Run(SinkFunction & sink)
+	{
+		Context context;
+		BoundedQueue<PipelineBatch<SourceItem>> input(queue_capacity_);
+		std::thread reader;
+
+		try
+		{
+			reader = std::thread([this, &context, &input]() { ReadSource(context, input); });
+		}
+		catch(...)
+		{
+			context.Fail(std::current_exception());
+			input.Close();
+		}
+
+		RunStage<0>(context, input, sink);
+
+		if(reader.joinable())
+		{
+			reader.join();
+		}
+
+		if(context.exception)
+		{
+			std::rethrow_exception(context.exception);
+		}
+	}
+};
+
+//-----------------------------------------------------------------------------------------
+// Pipeline関数 - rangeの要素をbatch_size個ずつまとめて、Stage()/Sink()に順に渡す
+//   rangeはZip()/Enumerate()等の範囲で、右辺値の場合はパイプラインの中に保持する
+//   各ステージはqueue_capacity個のまとまりを保持できるキューでつながる
+//-----------------------------------------------------------------------------------------
+template <class Range>
+auto Pipeline(Range && range, size_t batch_size = 1024, size_t queue_capacity = 16)
+{
+	return PipelineBuilder<Range>(std::forward<Range>(range), batch_size, queue_capacity, std::tuple<>());
+}
+
+#endif // __IZADORI_PIPELINE_H__
@@ -0,0 +1,263 @@
+﻿//
+// ranker.h
+//
+// Copyright (c) 2024 Izadori
+//
+// This software is released under the MIT License.
+// http://opensource.org/licenses/mit-license.php
+//
+
+#ifndef __IZADORI_RANKER_H__
+#define __IZADORI_RANKER_H__
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <optional>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "enumerator.h"
+#include "parallel.h"
+
+//-----------------------------------------------------------------------------------------
+// Enumerator<>に対するArgMax()/ArgMin()/TopK()関数の実装（C++17対応のコンパイラが必要）
+//   sourceはEnumerate()の結果（size()とoperator[]を持つ範囲）で、結果のインデックスは
+//   Enumerate()が返すインデックスと同じ値となる
+//-----------------------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------------------
+// IsTupleクラス - std::tuple<>かどうかを判定する
+//-----------------------------------------------------------------------------------------
+template <typename T>
+struct IsTuple : std::false_type {};
+
+template <typename... T>
+struct IsTuple<std::tuple<T...>> : std::true_type {};
+
+//-----------------------------------------------------------------------------------------
+// RankKeyクラス - 比較に使う値を返す（Zipper<>の場合は先頭の列の値）
+//-----------------------------------------------------------------------------------------
+struct RankKey
+{
+	template <class Row>
+	auto operator()(const Row & row) const
+	{
+		auto && value = std::get<1>(row);
+
+		if constexpr(IsTuple<std::decay_t<decltype(value)>>::value)
+		{
+			return std::get<0>(value);
+		}
+		else
+		{
+			return value;
+		}
+	}
+};
+
+//-----------------------------------------------------------------------------------------
+// RankEntryクラス - 比較に使う値と位置の組
+//-----------------------------------------------------------------------------------------
+template <typename T>
+struct RankEntry
+{
+	T key;
+	size_t position;
+};
+
+//-----------------------------------------------------------------------------------------
+// RankBetterクラス - compareで優先される方、同じ値の場合は位置が前の方を優先する
+//-----------------------------------------------------------------------------------------
+template <class Compare>
+struct RankBetter
+{
+	template <typename T>
+	bool operator()(const RankEntry<T> & a, const RankEntry<T> & b) const
+	{
+		Compare compare;
+		return compare(a.key, b.key) || (!compare(b.key, a.key) && a.position < b.position);
+	}
+};
+
+//-----------------------------------------------------------------------------------------
+// FindBest関数 - [begin, end)の中で最もcompareで優先される要素を求める
+//   8本の独立した比較列（レーン）で最良値と位置を保持し、最後にレーン間で統合する
+//-----------------------------------------------------------------------------------------
+template <class Compare, class Source, class Key>
+auto FindBest(Source & source, Key & key, size_t begin, size_t end)
+{
+	using key_type = std::decay_t<decltype(key(source[begin]))>;
+
+	constexpr size_t lanes = 8;
+	Compare compare;
+	RankBetter<Compare> better;
+	RankEntry<key_type> result{key(source[begin]), begin};
+	size_t i = begin + 1;
+
+	if(end - begin >= lanes * 2)
+	{
+		key_type best[lanes];
+		size_t position[lanes];
+
+		for(size_t j = 0; j < lanes; j++)
+		{
+			best[j] = key(source[begin + j]);
+			position[j] = begin + j;
+		}
+
+		for(i = begin + lanes; i + lanes <= end; i += lanes)
+		{
+			for(size_t j = 0; j < lanes; j++)
+			{
+				key_type value = key(source[i + j]);
+				bool update = compare(value, best[j]);
+				best[j] = update ? value : best[j];
+				position[j] = update ? i + j : position[j];
+			}
+		}
+
+		for(size_t j = 0; j < lanes; j++)
+		{
+			RankEntry<key_type> entry{best[j], position[j]};
+			result = better(entry, result) ? entry : result;
+		}
+	}
+
+	for(; i < end; i++)
+	{
+		key_type value = key(source[i]);
+
+		if(compare(value, result.key))
+		{
+			result = RankEntry<key_type>{value, i};
+		}
+	}
+
+	return result;
+}
+
+//-----------------------------------------------------------------------------------------
+// ArgBest関数 - 区間ごとに並列にFindBest()を行い、その結果を統合する
+//-----------------------------------------------------------------------------------------
+template <class Compare, class Source, class Key>
+std::optional<int> ArgBest(Source & source, Key & key, unsigned int num_threads)
+{
+	using entry_type = decltype(FindBest<Compare>(source, key, 0, 1));
+
+	size_t size = source.size();
+
+	if(size == 0)
+	{
+		return std::nullopt;
+	}
+
+	std::vector<std::optional<entry_type>> results(GetThreadCount(num_threads));
+
+	ParallelFor(size, [&](size_t begin, size_t end, unsigned int chunk) {
+		if(begin < end)
+		{
+			results[chunk] = FindBest<Compare>(source, key, begin, end);
+		}
+	}, num_threads);
+
+	RankBetter<Compare> better;
+	std::optional<entry_type> result;
+
+	for(auto & entry : results)
+	{
+		if(entry && (!result || better(*entry, *result)))
+		{
+			result = entry;
+		}
+	}
+
+	return std::get<0>(source[result->position]);
+}
+
+//-----------------------------------------------------------------------------------------
+// ArgMax関数 - 最大値の要素のインデックスを返す（同じ値の場合は先頭に近いもの、空の場合はstd::nullopt）
+//-----------------------------------------------------------------------------------------
+template <class Source, class Key = RankKey>
+std::optional<int> ArgMax(Source && source, Key key = Key(), unsigned int num_threads = 1)
+{
+	return ArgBest<std::greater<>>(source, key, num_threads);
+}
+
+//-----------------------------------------------------------------------------------------
+// ArgMin関数 - 最小値の要素のインデックスを返す（同じ値の場合は先頭に近いもの、空の場合はstd::nullopt）
+//-----------------------------------------------------------------------------------------
+template <class Source, class Key = RankKey>
+std::optional<int> ArgMin(Source && source, Key key = Key(), unsigned int num_threads = 1)
+{
+	return ArgBest<std::less<>>(source, key, num_threads);
+}
+
+//-----------------------------------------------------------------------------------------
+// TopK関数 - 値の大きい順に最大k個の要素（インデックスと値のタプル）を返す
+//   区間ごとに大きさkのヒープで候補を絞り込み、最後に全ての候補を統合して並べ替える
+//-----------------------------------------------------------------------------------------
+template <class Source, class Key = RankKey>
+auto TopK(Source && source, size_t k, Key key = Key(), unsigned int num_threads = 1)
+{
+	using row_type = decltype(source[0]);
+	using entry_type = RankEntry<std::decay_t<decltype(key(source[0]))>>;
+
+	size_t size = source.size();
+	std::vector<row_type> rows;
+
+	if(size == 0 || k == 0)
+	{
+		return rows;
+	}
+
+	RankBetter<std::greater<>> better;
+	std::vector<std::vector<entry_type>> heaps(GetThreadCount(num_threads));
+
+	ParallelFor(size, [&](size_t begin, size_t end, unsigned int chunk) {
+		auto & heap = heaps[chunk];
+
+		heap.reserve(std::min(k, end - begin));
+
+		// heap.front()は保持している候補の中で最も順位の低い要素
+		for(size_t i = begin; i < end; i++)
+		{
+			entry_type entry{key(source[i]), i};
+
+			if(heap.size() < k)
+			{
+				heap.push_back(entry);
+				std::push_heap(heap.begin(), heap.end(), better);
+			}
+			else if(better(entry, heap.front()))
+			{
+				std::pop_heap(heap.begin(), heap.end(), better);
+				heap.back() = entry;
+				std::push_heap(heap.begin(), heap.end(), better);
+			}
+		}
+	}, num_threads);
+
+	std::vector<entry_type> candidates;
+
+	for(auto & heap : heaps)
+	{
+		candidates.insert(candidates.end(), heap.begin(), heap.end());
+	}
+
+	size_t count = std::min(k, candidates.size());
+	std::partial_sort(candidates.begin(), candidates.begin() + count, candidates.end(), better);
+
+	rows.reserve(count);
+
+	for(size_t i = 0; i < count; i++)
+	{
+		rows.push_back(source[candidates[i].position]);
+	}
+
+	return rows;
+}
+
+#endif // __IZADORI_RANKER_H__
@@ -0,0 +1,288 @@
+﻿//
+// ringbuffer.h
+//
+// Copyright (c) 2024 Izadori
+//
+// This software is released under the MIT License.
+// http://opensource.org/licenses/mit-license.php
+//
+
+#ifndef __IZADORI_RINGBUFFER_H__
+#define __IZADORI_RINGBUFFER_H__
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <thread>
+#include <utility>
+
+#include "parallel.h"
+
+//-----------------------------------------------------------------------------------------
+// Zip()/Enumerate()で読み出せるロックフリーなリングバッファの実装（C++17対応のコンパイラが必要）
+//-----------------------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------------------
+// SpscRingBufferクラス - 書き込み側・読み出し側がそれぞれ1スレッドのロックフリーなリングバッファ
+//   読み出し側は一度だけ読める範囲として、Zip(quotes, trades)やEnumerate(quotes)に渡せる
+//   （各列の次の要素が揃うまで待ち、どれかがClose()されて空になると終了する）
+//   書き込み位置・読み出し位置はpublish_interval個ごとにまとめて公開し、キャッシュラインの
+//   行き来を減らす（すぐに読ませたい場合はFlush()を呼ぶ）
+//-----------------------------------------------------------------------------------------
+template <typename T>
+class SpscRingBuffer final
+{
+public:
+	SpscRingBuffer(size_t capacity = 1024, size_t publish_interval = 16) : head_(0), tail_(0), closed_(false)
+	{
+		size_t size = 2;
+
+		while(size < capacity)
+		{
+			size <<= 1;
+		}
+
+		mask_ = size - 1;
+		interval_ = std::max<size_t>(1, std::min(publish_interval, size / 2));
+		items_ = std::make_unique<T[]>(size);
+	}
+
+	SpscRingBuffer(const SpscRingBuffer &) = delete;
+	SpscRingBuffer & operator=(const SpscRingBuffer &) = delete;
+
+	//-------------------------------------------------------------------------------------
+	// 書き込み側（1スレッドのみ）
+	//-------------------------------------------------------------------------------------
+
+	// 空きがあれば追加する（満杯の場合はfalseを返す）
+	template <typename U>
+	bool TryPush(U && item)
+	{
+		if(producer_.write - producer_.cached_head > mask_)
+		{
+			// 満杯の場合は、書き込み済みの要素を公開してから読み出し側の位置を読み直す
+			PublishTail();
+			producer_.cached_head = head_.load(std::memory_order_acquire);
+
+			if(producer_.write - producer_.cached_head > mask_)
+			{
+				return false;
+			}
+		}
+
+		items_[producer_.write & mask_] = std::forward<U>(item);
+
+		if(++producer_.write - producer_.published >= interval_)
+		{
+			PublishTail();
+		}
+
+		return true;
+	}
+
+	// 空きができるまで待ってから追加する
+	template <typename U>
+	void Push(U && item)
+	{
+		while(!TryPush(std::forward<U>(item)))
+		{
+			std::this_thread::yield();
+		}
+	}
+
+	// 公開していない要素を読み出し側に公開する
+	void Flush()
+	{
+		PublishTail();
+	}
+
+	// これ以上追加しないことを通知する（追加済みの要素は読み出せる）
+	void Close()
+	{
+		PublishTail();
+		closed_.store(true, std::memory_order_release);
+	}
+
+	//-------------------------------------------------------------------------------------
+	// 読み出し側（1スレッドのみ）
+	//-------------------------------------------------------------------------------------
+
+	// 要素があれば取り出す（空の場合はfalseを返す）
+	bool TryPop(T & item)
+	{
+		if(!IsReadable())
+		{
+			return false;
+		}
+
+		item = std::move(items_[consumer_.read & mask_]);
+		Advance();
+
+		return true;
+	}
+
+	// 要素が追加されるまで待つ（Close()されて空になった場合はfalseを返す）
+	bool Wait()
+	{
+		while(!IsReadable())
+		{
+			if(closed_.load(std::memory_order_acquire))
+			{
+				// Close()の前に公開された要素が残っていないか確認する
+				return IsReadable();
+			}
+
+			std::this_thread::yield();
+		}
+
+		return true;
+	}
+
+	//-------------------------------------------------------------------------------------
+	// Iteratorクラス - 読み出し側の入力イテレータ
+	//   比較で次の要素が届くまで待ち、++で読み出し位置を進める（要素はそれまでバッファの中にある）
+	//-------------------------------------------------------------------------------------
+	class Iterator final
+	{
+	public:
+		using iterator_category = std::input_iterator_tag;
+		using value_type = T;
+		using difference_type = std::ptrdiff_t;
+		using pointer = T *;
+		using reference = T &;
+
+		Iterator() : buffer_(nullptr) {}
+
+		bool operator==(const Iterator & it) const
+		{
+			return IsEnd() == it.IsEnd();
+		}
+
+		bool operator!=(const Iterator & it) const
+		{
+			return !(*this == it);
+		}
+
+		Iterator & operator++()
+		{
+			buffer_->Advance();
+			return *this;
+		}
+
+		Iterator operator++(int)
+		{
+			Iterator it = *this;
+			++*this;
+			return it;
+		}
+
+		T & operator*() const
+		{
+			return buffer_->items_[buffer_->consumer_.read & buffer_->mask_];
+		}
+
+		T * operator->() const
+		{
+			return &**this;
+		}
+
+	private:
+		SpscRingBuffer * buffer_;
+
+		Iterator(SpscRingBuffer * buffer) : buffer_(buffer) {}
+
+		bool IsEnd() const
+		{
+			return buffer_ == nullptr || !buffer_->Wait();
+		}
+
+		friend SpscRingBuffer;
+	};
+
+	using iterator = Iterator;
+
+	Iterator begin()
+	{
+		return Iterator(this);
+	}
+
+	Iterator end()
+	{
+		return Iterator();
+	}
+
+	size_t capacity() const
+	{
+		return mask_ + 1;
+	}
+
+private:
+	// 書き込み側だけが使う状態（公開済みの位置・読み出し側の位置の写し）
+	struct ProducerState
+	{
+		size_t write = 0;
+		size_t published = 0;
+		size_t cached_head = 0;
+	};
+
+	// 読み出し側だけが使う状態（公開済みの位置・書き込み側の位置の写し）
+	struct ConsumerState
+	{
+		size_t read = 0;
+		size_t published = 0;
+		size_t cached_tail = 0;
+	};
+
+	size_t mask_;
+	size_t interval_;
+	std::unique_ptr<T[]> items_;
+	alignas(cache_line_size) std::atomic<size_t> head_;
+	alignas(cache_line_size) std::atomic<size_t> tail_;
+	alignas(cache_line_size) std::atomic<bool> closed_;
+	alignas(cache_line_size) ProducerState producer_;
+	alignas(cache_line_size) ConsumerState consumer_;
+
+	void PublishTail()
+	{
+		if(producer_.published != producer_.write)
+		{
+			producer_.published = producer_.write;
+			tail_.store(producer_.write, std::memory_order_release);
+		}
+	}
+
+	void PublishHead()
+	{
+		if(consumer_.published != consumer_.read)
+		{
+			consumer_.published = consumer_.read;
+			head_.store(consumer_.read, std::memory_order_release);
+		}
+	}
+
+	bool IsReadable()
+	{
+		if(consumer_.read != consumer_.cached_tail)
+		{
+			return true;
+		}
+
+		// 空に見える場合は、読み終えた位置を公開してから書き込み側の位置を読み直す
+		PublishHead();
+		consumer_.cached_tail = tail_.load(std::memory_order_acquire);
+
+		return consumer_.read != consumer_.cached_tail;
+	}
+
+	void Advance()
+	{
+		if(++consumer_.read - consumer_.published >= interval_)
+		{
+			PublishHead();
+		}
+	}
+};
+
+#endif // __IZADORI_RINGBUFFER_H__
@@ -0,0 +1,133 @@
+﻿//
+// rowranges.h
+//
+// Copyright (c) 2024 Izadori
+//
+// This software is released under the MIT License.
+// http://opensource.org/licenses/mit-license.php
+//
+
+#ifndef __IZADORI_ROWRANGES_H__
+#define __IZADORI_ROWRANGES_H__
+
+#include <algorithm>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+//-----------------------------------------------------------------------------------------
+// 行の区間の集合の実装（C++17対応のコンパイラが必要）
+//-----------------------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------------------
+// RowRangesクラス - 互いに重ならない昇順の行の区間[begin, end)の集合
+//   EnumerateSelected()のマスクとして指定すると、区間に含まれない行をまとめて読み飛ばす
+//-----------------------------------------------------------------------------------------
+class RowRanges final
+{
+public:
+	using Range = std::pair<size_t, size_t>;
+
+	RowRanges() = default;
+
+	// [begin, end)を末尾に追加する（直前の区間と接する・重なる場合は1つにまとめる）
+	//   beginは直前に追加した区間のbegin以上でなければならない
+	void Add(size_t begin, size_t end)
+	{
+		if(begin >= end)
+		{
+			return;
+		}
+
+		if(!ranges_.empty() && begin <= ranges_.back().second)
+		{
+			ranges_.back().second = std::max(ranges_.back().second, end);
+		}
+		else
+		{
+			ranges_.emplace_back(begin, end);
+		}
+	}
+
+	// 両方に含まれる行の区間を返す
+	RowRanges Intersect(const RowRanges & ranges) const
+	{
+		RowRanges result;
+		size_t i = 0, j = 0;
+
+		while(i < ranges_.size() && j < ranges.ranges_.size())
+		{
+			const Range & a = ranges_[i];
+			const Range & b = ranges.ranges_[j];
+
+			result.Add(std::max(a.first, b.first), std::min(a.second, b.second));
+
+			if(a.second < b.second)
+			{
+				i++;
+			}
+			else
+			{
+				j++;
+			}
+		}
+
+		return result;
+	}
+
+	// size行目以降を除いた区間を返す
+	RowRanges Truncate(size_t size) const
+	{
+		RowRanges result;
+
+		for(auto & range : ranges_)
+		{
+			result.Add(range.first, std::min(range.second, size));
+		}
+
+		return result;
+	}
+
+	// 含まれる行の総数を返す
+	size_t Count() const
+	{
+		size_t count = 0;
+
+		for(auto & range : ranges_)
+		{
+			count += range.second - range.first;
+		}
+
+		return count;
+	}
+
+	size_t size() const
+	{
+		return ranges_.size();
+	}
+
+	bool empty() const
+	{
+		return ranges_.empty();
+	}
+
+	const Range & operator[](size_t n) const
+	{
+		return ranges_[n];
+	}
+
+	std::vector<Range>::const_iterator begin() const
+	{
+		return ranges_.begin();
+	}
+
+	std::vector<Range>::const_iterator end() const
+	{
+		return ranges_.end();
+	}
+
+private:
+	std::vector<Range> ranges_;
+};
+
+#endif // __IZADORI_ROWRANGES_H__
@@ -0,0 +1,174 @@
+﻿//
+// scanner.h
+//
+// Copyright (c) 2024 Izadori
+//
+// This software is released under the MIT License.
+// http://opensource.org/licenses/mit-license.php
+//
+
+#ifndef __IZADORI_SCANNER_H__
+#define __IZADORI_SCANNER_H__
+
+#include <cstddef>
+#include <functional>
+#include <utility>
+#include <vector>
+
+#include "parallel.h"
+#include "zipper.h"
+
+//-----------------------------------------------------------------------------------------
+// Zipper/Enumeratorに対する累積演算（スキャン）の実装（C++17対応のコンパイラが必要）
+//   sourceはsize()とoperator[]を持つ範囲、outputはresize()可能なランダムアクセスコンテナ
+//   transform(row)で各行を値に変換し、その値をopで累積した結果をoutputに書き出す
+//-----------------------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------------------
+// InclusiveScan関数 - output[i] = x[0] op x[1] op ... op x[i]
+//-----------------------------------------------------------------------------------------
+template <class Source, class Output, class Transform, class BinaryOp = std::plus<>>
+void InclusiveScan(Source && source, Output & output, Transform && transform, BinaryOp op = BinaryOp())
+{
+	size_t size = source.size();
+
+	output.resize(size);
+
+	if(size == 0)
+	{
+		return;
+	}
+
+	GetValueType<Output> sum = transform(source[0]);
+	output[0] = sum;
+
+	for(size_t i = 1; i < size; i++)
+	{
+		sum = op(sum, transform(source[i]));
+		output[i] = sum;
+	}
+}
+
+//-----------------------------------------------------------------------------------------
+// ExclusiveScan関数 - output[0] = init, output[i] = init op x[0] op ... op x[i - 1]
+//-----------------------------------------------------------------------------------------
+template <class Source, class Output, class T, class Transform, class BinaryOp = std::plus<>>
+void ExclusiveScan(Source && source, Output & output, T init, Transform && transform, BinaryOp op = BinaryOp())
+{
+	size_t size = source.size();
+	GetValueType<Output> sum = init;
+
+	output.resize(size);
+
+	for(size_t i = 0; i < size; i++)
+	{
+		GetValueType<Output> value = transform(source[i]);
+		output[i] = sum;
+		sum = op(sum, value);
+	}
+}
+
+//-----------------------------------------------------------------------------------------
+// ScanImpl関数 - 3段階のブロック並列スキャン
+//   1. 各区間の合計を並列に求める
+//   2. 区間の合計の累積から各区間の初期値（キャリー）を求める
+//   3. 各区間をキャリーから並列にスキャンし直して書き出す
+//   opは結合則を満たす必要がある
+//-----------------------------------------------------------------------------------------
+template <bool Inclusive, class Source, class Output, class T, class Transform, class BinaryOp>
+void ScanImpl(Source & source, Output & output, const T * init, Transform & transform, BinaryOp & op, unsigned int num_threads)
+{
+	using value_type = GetValueType<Output>;
+
+	size_t size = source.size();
+	size_t chunks = GetThreadCount(num_threads);
+	std::vector<value_type> totals(chunks);
+	std::vector<unsigned char> used(chunks, 0);
+
+	output.resize(size);
+
+	// 3段階目の書き込みが偽共有しないよう、区間の境界をoutputのキャッシュラインの境界に揃える
+	RowAlignment alignment = GetRowAlignment(Zip(output));
+
+	ParallelFor(size, [&](size_t begin, size_t end, unsigned int chunk) {
+		if(begin == end)
+		{
+			return;
+		}
+
+		value_type sum = transform(source[begin]);
+
+		for(size_t i = begin + 1; i < end; i++)
+		{
+			sum = op(sum, transform(source[i]));
+		}
+
+		totals[chunk] = sum;
+		used[chunk] = 1;
+	}, num_threads, alignment);
+
+	// carries[c]は区間cより前の全ての値の累積（carried[c]が0の場合は累積する値が無い）
+	std::vector<value_type> carries(chunks);
+	std::vector<unsigned char> carried(chunks, 0);
+
+	if(init != nullptr)
+	{
+		carries[0] = *init;
+		carried[0] = 1;
+	}
+
+	for(size_t c = 1; c < chunks; c++)
+	{
+		carries[c] = carries[c - 1];
+		carried[c] = carried[c - 1];
+
+		if(used[c - 1])
+		{
+			carries[c] = carried[c - 1] ? op(carries[c - 1], totals[c - 1]) : totals[c - 1];
+			carried[c] = 1;
+		}
+	}
+
+	ParallelFor(size, [&](size_t begin, size_t end, unsigned int chunk) {
+		bool carry = carried[chunk] != 0;
+		value_type sum = carries[chunk];
+
+		for(size_t i = begin; i < end; i++)
+		{
+			value_type value = transform(source[i]);
+
+			if constexpr(Inclusive)
+			{
+				sum = carry ? op(sum, value) : value;
+				carry = true;
+				output[i] = sum;
+			}
+			else
+			{
+				output[i] = sum;
+				sum = op(sum, value);
+			}
+		}
+	}, num_threads, alignment);
+}
+
+//-----------------------------------------------------------------------------------------
+// InclusiveScan関数（並列版）
+//-----------------------------------------------------------------------------------------
+template <class Source, class Output, class Transform, class BinaryOp = std::plus<>>
+void InclusiveScan(Source && source, Output & output, Transform && transform, BinaryOp op, unsigned int num_threads)
+{
+	ScanImpl<true>(source, output, (const GetValueType<Output> *)nullptr, transform, op, num_threads);
+}
+
+//-----------------------------------------------------------------------------------------
+// ExclusiveScan関数（並列版）
+//-----------------------------------------------------------------------------------------
+template <class Source, class Output, class T, class Transform, class BinaryOp = std::plus<>>
+void ExclusiveScan(Source && source, Output & output, T init, Transform && transform, BinaryOp op, unsigned int num_threads)
+{
+	GetValueType<Output> first = init;
+	ScanImpl<false>(source, output, &first, transform, op, num_threads);
+}
+
+#endif // __IZADORI_SCANNER_H__
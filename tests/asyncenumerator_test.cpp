@@ -0,0 +1,190 @@
+﻿//
+// asyncenumerator_test.cpp
+//
+// Copyright (c) 2024 Izadori
+//
+// This software is released under the MIT License.
+// http://opensource.org/licenses/mit-license.php
+//
+
+#include <algorithm>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "asyncenumerator.h"
+#include "test.h"
+
+//-----------------------------------------------------------------------------------------
+// AsyncEnumerate()のテスト（C++20が必要）
+//-----------------------------------------------------------------------------------------
+
+// co_awaitしたコルーチンを別スレッドで再開する（JoinAll()でまとめてjoinする）
+class ResumeOnThread final
+{
+public:
+	bool await_ready()
+	{
+		return false;
+	}
+
+	void await_suspend(std::coroutine_handle<> handle)
+	{
+		std::lock_guard<std::mutex> lock(Mutex());
+		Threads().emplace_back([handle]() { handle.resume(); });
+	}
+
+	void await_resume() {}
+
+	static void JoinAll()
+	{
+		while(true)
+		{
+			std::vector<std::thread> threads;
+
+			{
+				std::lock_guard<std::mutex> lock(Mutex());
+				threads.swap(Threads());
+			}
+
+			if(threads.empty())
+			{
+				return;
+			}
+
+			for(auto & thread : threads)
+			{
+				thread.join();
+			}
+		}
+	}
+
+private:
+	static std::mutex & Mutex()
+	{
+		static std::mutex mutex;
+		return mutex;
+	}
+
+	static std::vector<std::thread> & Threads()
+	{
+		static std::vector<std::thread> threads;
+		return threads;
+	}
+};
+
+// batch個ずつ値を返すソース（別スレッドで完了する）
+class Source final
+{
+public:
+	Source(int size, int batch) : size_(size), batch_(batch), position_(0), which_(0) {}
+
+	Task<std::span<int>> Next()
+	{
+		co_await ResumeOnThread();
+
+		if(position_ >= size_)
+		{
+			co_return std::span<int>();
+		}
+
+		std::vector<int> & buffer = buffers_[which_ ^= 1];
+		int count = std::min(batch_, size_ - position_);
+
+		buffer.resize(count);
+
+		for(int i = 0; i < count; i++)
+		{
+			buffer[i] = position_ + i;
+		}
+
+		position_ += count;
+		co_return std::span<int>(buffer);
+	}
+
+private:
+	int size_;
+	int batch_;
+	int position_;
+	int which_;
+	std::vector<int> buffers_[2];
+};
+
+Task<long long> Consume(Source & source, int initial_index, int step, bool & ordered)
+{
+	auto batches = AsyncEnumerate(source, initial_index, step);
+	long long sum = 0;
+	int expected = 0;
+
+	while(auto batch = co_await batches.Next())
+	{
+		for(auto [i, value] : *batch)
+		{
+			ordered = ordered && value == expected && i == initial_index + expected * step;
+			sum += value;
+			expected++;
+		}
+	}
+
+	co_return sum;
+}
+
+void TestAsyncEnumerate()
+{
+	bool ordered = true;
+	Source source(1000, 7);
+
+	CHECK(SyncWait(Consume(source, 100, 3, ordered)) == 499500);
+	CHECK(ordered);
+
+	Source empty(0, 7);
+	CHECK(SyncWait(Consume(empty, 0, 1, ordered)) == 0);
+}
+
+// 先読みしたタスクが待ち始める直前に完了する場合も、コルーチンのフレームを解放する
+//   （-fsanitize=addressでリークがないことを確認する）
+void TestPrefetchRace()
+{
+	bool ordered = true;
+
+	for(int r = 0; r < 200; r++)
+	{
+		Source source(64, 1);
+		CHECK(SyncWait(Consume(source, 0, 1, ordered)) == 2016);
+		ResumeOnThread::JoinAll();
+	}
+
+	CHECK(ordered);
+}
+
+Task<int> Throw()
+{
+	co_await ResumeOnThread();
+	throw 5;
+}
+
+void TestException()
+{
+	bool thrown = false;
+
+	try
+	{
+		SyncWait(Throw());
+	}
+	catch(int e)
+	{
+		thrown = e == 5;
+	}
+
+	CHECK(thrown);
+}
+
+int main()
+{
+	TestAsyncEnumerate();
+	TestPrefetchRace();
+	TestException();
+	ResumeOnThread::JoinAll();
+
+	return TEST_RESULT();
+}
@@ -0,0 +1,216 @@
+﻿//
+// bitcolumn_test.cpp
+//
+// Copyright (c) 2024 Izadori
+//
+// This software is released under the MIT License.
+// http://opensource.org/licenses/mit-license.php
+//
+
+#include <cstdint>
+#include <mutex>
+#include <tuple>
+#include <vector>
+
+#include "bitcolumn.h"
+#include "parallel.h"
+#include "threadpool.h"
+#include "test.h"
+
+//-----------------------------------------------------------------------------------------
+// BitColumnのワード単位の演算・末尾のワードのマスク・並列処理の区間の境界のテスト
+//-----------------------------------------------------------------------------------------
+
+// 末尾のワードのsize()を超える部分のビットが0かどうか
+static bool PaddingIsClear(const BitColumn & column)
+{
+	size_t rest = column.size() % BitColumn::word_bits;
+	return rest == 0 || (column.Words()[column.WordCount() - 1] >> rest) == 0;
+}
+
+static BitColumn MakeColumn(size_t size, size_t step)
+{
+	BitColumn column(size);
+
+	for(size_t i = 0; i < size; i += step)
+	{
+		column[i] = true;
+	}
+
+	return column;
+}
+
+void TestWordOps()
+{
+	BitColumn a = MakeColumn(200, 3), b = MakeColumn(200, 5);
+	BitColumn and_ = a, or_ = a, xor_ = a;
+
+	and_ &= b;
+	or_ |= b;
+	xor_ ^= b;
+
+	bool ok = true;
+
+	for(size_t i = 0; i < 200; i++)
+	{
+		bool x = i % 3 == 0, y = i % 5 == 0;
+		ok = ok && and_[i] == (x && y) && or_[i] == (x || y) && xor_[i] == (x != y);
+	}
+
+	CHECK(ok);
+	CHECK(and_.Count() == 14 && or_.Count() == 67 + 40 - 14);
+
+	// 短い列との演算では、残りの行は0との演算になる
+	BitColumn short_column(70, true);
+	BitColumn c = a;
+
+	c &= short_column;
+	CHECK(c.Count() == 24);
+	c = a;
+	c |= short_column;
+	CHECK(c.Count() == 70 + (67 - 24));
+	CHECK(PaddingIsClear(c));
+}
+
+// 反転・拡張・縮小の後も末尾のワードの余りのビットは0のまま
+void TestTailMask()
+{
+	BitColumn column(70);
+
+	column.Flip();
+	CHECK(column.Count() == 70 && PaddingIsClear(column));
+
+	column.resize(100, true);
+	CHECK(column.Count() == 100 && PaddingIsClear(column));
+
+	column.resize(65);
+	CHECK(column.Count() == 65 && PaddingIsClear(column));
+
+	column.resize(130, false);
+	CHECK(column.Count() == 65 && PaddingIsClear(column));
+
+	column.push_back(true);
+	CHECK(column.size() == 131 && column[130] && PaddingIsClear(column));
+
+	BitColumn a(70, true), b(100, true);
+	BitColumn both = BitAnd(Zip(a, b));
+
+	// Zipper<>の行数（短い方の列）を超える部分は数えない
+	CHECK(both.size() == 70 && both.Count() == 70 && PaddingIsClear(both));
+	CHECK(CountAnd(Zip(a, b)) == 70);
+	CHECK(CountOr(Zip(b, a)) == 70);
+}
+
+// 64バイト境界から16バイトずれた位置を指すdoubleの列
+struct OffsetColumn
+{
+	double * first;
+	size_t count;
+
+	double * data()
+	{
+		return first;
+	}
+
+	double * begin()
+	{
+		return first;
+	}
+
+	double * end()
+	{
+		return first + count;
+	}
+
+	size_t size() const
+	{
+		return count;
+	}
+};
+
+// 1行が1ビットの列がある場合は、多数決ではなく全ての区間の境界をワードの先頭に揃える
+void TestPackedRowAlignment()
+{
+	constexpr size_t rows = 20000;
+
+	std::vector<double, CacheAlignedAllocator<double>> buffer(rows * 3 + 8);
+	OffsetColumn x{buffer.data() + 2, rows}, y{buffer.data() + 2 + rows, rows}, z{buffer.data() + 2 + rows * 2, rows};
+	BitColumn bits(rows);
+
+	CHECK((uintptr_t)x.data() % cache_line_size == 16);
+
+	RowAlignment alignment = GetRowAlignment(Zip(x, y, z, bits));
+
+	CHECK(alignment.phase % BitColumn::word_bits == 0);
+	CHECK(alignment.period % BitColumn::word_bits == 0);
+
+	std::vector<size_t> begins;
+	std::mutex mutex;
+
+	ParallelFor(rows, [&](size_t begin, size_t end, unsigned int) {
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			begins.push_back(begin);
+		}
+
+		for(size_t i = begin; i < end; i++)
+		{
+			bits[i] = x.first[i] > 0;
+		}
+	}, 8, alignment);
+
+	bool aligned = true;
+
+	for(size_t begin : begins)
+	{
+		aligned = aligned && begin % BitColumn::word_bits == 0;
+	}
+
+	CHECK(aligned);
+}
+
+// 複数のスレッドが同じワードに書き込まなければ、全ての行の値が残る
+void TestParallelWrite()
+{
+	constexpr size_t rows = 100000;
+
+	std::vector<double, CacheAlignedAllocator<double>> buffer(rows * 3 + 8);
+	OffsetColumn x{buffer.data() + 2, rows}, y{buffer.data() + 2 + rows, rows}, z{buffer.data() + 2 + rows * 2, rows};
+	BitColumn bits(rows);
+
+	for(size_t i = 0; i < rows; i++)
+	{
+		x.first[i] = i % 7 == 0 ? 1.0 : 0.0;
+	}
+
+	// ハードウェアのスレッド数によらず、ワーカーのスレッドで並列に書き込む
+	ThreadPool pool(4);
+	auto zipper = Zip(x, y, z, bits);
+
+	ParallelFor(pool, rows, [&](size_t begin, size_t end, unsigned int) {
+		for(size_t i = begin; i < end; i++)
+		{
+			bits[i] = x.first[i] > 0;
+		}
+	}, 16, GetRowAlignment(zipper));
+
+	CHECK(bits.Count() == (rows + 6) / 7);
+
+	BitColumn flags(rows);
+
+	ParallelForEach(Zip(x, flags), [](auto row) {
+		std::get<1>(row) = std::get<0>(row) > 0;
+	});
+
+	CHECK(flags.Count() == (rows + 6) / 7);
+}
+
+int main()
+{
+	TestWordOps();
+	TestTailMask();
+	TestPackedRowAlignment();
+	TestParallelWrite();
+
+	return TEST_RESULT();
+}
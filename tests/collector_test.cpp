@@ -0,0 +1,102 @@
+﻿//
+// collector_test.cpp
+//
+// Copyright (c) 2024 Izadori
+//
+// This software is released under the MIT License.
+// http://opensource.org/licenses/mit-license.php
+//
+
+#include <tuple>
+#include <vector>
+
+#include "collector.h"
+#include "test.h"
+
+//-----------------------------------------------------------------------------------------
+// Compact()のテスト
+//-----------------------------------------------------------------------------------------
+
+// predicateが真の行を順に集めた期待値
+static void Expected(const std::vector<int> & a, const std::vector<double> & b, int divisor, std::vector<int> & ea, std::vector<double> & eb)
+{
+	for(size_t i = 0; i < a.size(); i++)
+	{
+		if(a[i] % divisor == 0)
+		{
+			ea.push_back(a[i]);
+			eb.push_back(b[i]);
+		}
+	}
+}
+
+void TestCompact()
+{
+	std::vector<int> a(1000);
+	std::vector<double> b(1000);
+
+	for(int i = 0; i < 1000; i++)
+	{
+		a[i] = (i * 37) % 101;
+		b[i] = i * 0.5;
+	}
+
+	for(int divisor : {1, 3, 7, 1000})
+	{
+		auto predicate = [divisor](auto row) { return std::get<0>(row) % divisor == 0; };
+		std::vector<int> ea;
+		std::vector<double> eb;
+
+		Expected(a, b, divisor, ea, eb);
+
+		std::vector<int> oa;
+		std::vector<double> ob;
+		size_t count = Compact(Zip(a, b), predicate, Zip(oa, ob));
+
+		CHECK(count == ea.size());
+		CHECK(oa == ea && ob == eb);
+
+		// 並列版は区間数によらず同じ結果になる
+		for(unsigned int threads : {1u, 2u, 3u, 8u, 64u})
+		{
+			std::vector<int> pa;
+			std::vector<double> pb;
+
+			CHECK(Compact(Zip(a, b), predicate, Zip(pa, pb), threads) == ea.size());
+			CHECK(pa == ea && pb == eb);
+		}
+	}
+}
+
+// 出力先の既存の行の後ろに追加する
+void TestCompactAppend()
+{
+	std::vector<int> a{1, 2, 3, 4, 5, 6};
+	std::vector<int> output{-1, -2};
+	auto even = [](auto row) { return std::get<0>(row) % 2 == 0; };
+
+	CHECK(Compact(Zip(a), even, Zip(output)) == 3);
+	CHECK((output == std::vector<int>{-1, -2, 2, 4, 6}));
+
+	CHECK(Compact(Zip(a), even, Zip(output), 4) == 3);
+	CHECK((output == std::vector<int>{-1, -2, 2, 4, 6, 2, 4, 6}));
+}
+
+void TestCompactEmpty()
+{
+	std::vector<int> a, output;
+	auto all = [](auto) { return true; };
+
+	CHECK(Compact(Zip(a), all, Zip(output)) == 0);
+	CHECK(Compact(Zip(a), all, Zip(output), 4) == 0);
+	CHECK(output.empty());
+}
+
+int main()
+{
+	TestCompact();
+	TestCompactAppend();
+	TestCompactEmpty();
+
+	return TEST_RESULT();
+}
@@ -0,0 +1,117 @@
+﻿//
+// columnfile_test.cpp
+//
+// Copyright (c) 2024 Izadori
+//
+// This software is released under the MIT License.
+// http://opensource.org/licenses/mit-license.php
+//
+
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "columnfile.h"
+#include "test.h"
+
+//-----------------------------------------------------------------------------------------
+// WriteColumnFile()・ColumnFile<>のテスト
+//-----------------------------------------------------------------------------------------
+
+static std::string TempPath(const std::string & name)
+{
+	return (std::filesystem::temp_directory_path() / name).string();
+}
+
+void TestRoundTrip()
+{
+	std::string path = TempPath("izadori_columnfile_test.col");
+	std::vector<int> values(1000);
+
+	for(int i = 0; i < 1000; i++)
+	{
+		values[i] = i;
+	}
+
+	WriteColumnFile(path, values, 100);
+
+	{
+		ColumnFile<int> column(path);
+		RowRanges ranges = column.FindBlocks(250, 420);
+
+		CHECK(column.size() == 1000);
+		CHECK(column.BlockCount() == 10);
+		CHECK(column[999] == 999);
+		CHECK(ranges.size() == 1 && ranges[0].first == 200 && ranges[0].second == 500);
+	}
+
+	std::filesystem::remove(path);
+}
+
+// フッタを書き換えた列ファイルを作り、開けないことを確かめる
+//   values個のint、2ブロック分のゾーンマップ、フッタの順に並べる
+static bool Rejects(uint64_t rows, uint64_t block_rows, uint64_t zone_offset, uint64_t block_count)
+{
+	std::string path = TempPath("izadori_columnfile_corrupt.col");
+	std::vector<char> bytes(8 + 2 * sizeof(ZoneMap<int>), 0);
+	ColumnFileFooter footer;
+
+	std::memset(&footer, 0, sizeof(footer));
+	std::memcpy(footer.magic, ColumnFileFooter::signature, sizeof(footer.magic));
+	footer.value_size = sizeof(int);
+	footer.kind = ColumnFileFooter::GetKind<int>();
+	footer.rows = rows;
+	footer.block_rows = block_rows;
+	footer.zone_offset = zone_offset;
+	footer.block_count = block_count;
+
+	{
+		std::ofstream file(path, std::ios::binary | std::ios::trunc);
+		file.write(bytes.data(), (std::streamsize)bytes.size());
+		file.write((const char *)&footer, sizeof(footer));
+	}
+
+	bool rejected = false;
+
+	try
+	{
+		ColumnFile<int> column(path);
+	}
+	catch(const std::runtime_error &)
+	{
+		rejected = true;
+	}
+
+	std::filesystem::remove(path);
+	return rejected;
+}
+
+void TestCorruptFooter()
+{
+	// 正しいフッタ（2行、1行ずつのブロック）は開ける
+	CHECK(!Rejects(2, 1, 8, 2));
+
+	// rows * sizeof(T)が桁あふれして小さな値になる
+	CHECK(Rejects((uint64_t(1) << 62) + 1, uint64_t(1) << 62, 8, 2));
+
+	// block_count * sizeof(ZoneMap<T>)が桁あふれする
+	CHECK(Rejects(uint64_t(1) << 60, 1, 8, uint64_t(1) << 60));
+
+	// zone_offset + ゾーンマップ + フッタが桁あふれする
+	CHECK(Rejects(0, 1, ~uint64_t(0) - 7, 0));
+
+	// ゾーンマップがファイルに収まらない
+	CHECK(Rejects(3, 1, 8, 3));
+}
+
+int main()
+{
+	TestRoundTrip();
+	TestCorruptFooter();
+
+	return TEST_RESULT();
+}
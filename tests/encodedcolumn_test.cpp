@@ -0,0 +1,133 @@
+﻿//
+// encodedcolumn_test.cpp
+//
+// Copyright (c) 2024 Izadori
+//
+// This software is released under the MIT License.
+// http://opensource.org/licenses/mit-license.php
+//
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "encodedcolumn.h"
+#include "test.h"
+
+//-----------------------------------------------------------------------------------------
+// EncodedColumn<>のテスト
+//-----------------------------------------------------------------------------------------
+
+static const ColumnEncoding encodings[] = {
+	ColumnEncoding::Auto, ColumnEncoding::Delta, ColumnEncoding::FrameOfReference, ColumnEncoding::RunLength, ColumnEncoding::Dictionary,
+};
+
+// 線形合同法による再現可能な乱数
+static uint64_t NextRandom(uint64_t & state)
+{
+	state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+	return state >> 11;
+}
+
+// 連番・ラン・少ない種類の値・型の範囲の両端を含む乱数・定数の列
+template <typename T>
+static std::vector<std::vector<T>> MakeColumns(size_t size)
+{
+	std::vector<std::vector<T>> columns(5, std::vector<T>(size));
+	uint64_t state = size;
+
+	for(size_t i = 0; i < size; i++)
+	{
+		columns[0][i] = (T)(i * 3 + (NextRandom(state) % 3));
+		columns[1][i] = (T)((i / 37) % 5);
+		columns[2][i] = (T)((NextRandom(state) % 4) * 1000 - 1500);
+		columns[3][i] = (T)NextRandom(state);
+		columns[4][i] = (T)42;
+	}
+
+	if(size >= 2)
+	{
+		columns[3][0] = std::numeric_limits<T>::min();
+		columns[3][size - 1] = std::numeric_limits<T>::max();
+	}
+
+	return columns;
+}
+
+// イテレータとDecodeBlock()のどちらで展開しても元の値に戻る
+template <typename T>
+static bool RoundTrip(const std::vector<T> & values, ColumnEncoding encoding, size_t block_rows)
+{
+	EncodedColumn<T> column(values, encoding, block_rows);
+	std::vector<T> iterated, decoded(column.BlockRows());
+
+	for(auto value : column)
+	{
+		iterated.push_back(value);
+	}
+
+	bool ok = column.size() == values.size() && iterated == values;
+	size_t row = 0;
+
+	for(size_t b = 0; ok && b < column.BlockCount(); b++)
+	{
+		size_t rows = column.DecodeBlock(b, decoded.data());
+
+		ok = encoding == ColumnEncoding::Auto || column.GetBlock(b).encoding == encoding;
+
+		for(size_t i = 0; ok && i < rows; i++)
+		{
+			ok = decoded[i] == values[row + i];
+		}
+
+		row += rows;
+	}
+
+	return ok && row == values.size();
+}
+
+template <typename T>
+void TestRoundTrip()
+{
+	for(size_t size : {0, 1, 2, 100, 256, 257, 3000})
+	{
+		for(auto & values : MakeColumns<T>(size))
+		{
+			for(ColumnEncoding encoding : encodings)
+			{
+				CHECK(RoundTrip(values, encoding, 256));
+			}
+		}
+	}
+}
+
+// Autoはブロックごとに最も小さい方式を選ぶため、どの方式を固定した場合よりも大きくならない
+void TestAutoIsSmallest()
+{
+	for(auto & values : MakeColumns<int64_t>(5000))
+	{
+		size_t bytes = EncodedColumn<int64_t>(values, ColumnEncoding::Auto, 512).CompressedBytes();
+
+		for(ColumnEncoding encoding : encodings)
+		{
+			CHECK(bytes <= EncodedColumn<int64_t>(values, encoding, 512).CompressedBytes());
+		}
+	}
+
+	// 定数の列は値を詰めて格納する必要がない
+	std::vector<int> constant(1024, 7);
+	EncodedColumn<int> column(constant, ColumnEncoding::Auto, 1024);
+	CHECK(column.BlockCount() == 1 && column.GetBlock(0).width == 0);
+}
+
+int main()
+{
+	TestRoundTrip<int8_t>();
+	TestRoundTrip<uint16_t>();
+	TestRoundTrip<int32_t>();
+	TestRoundTrip<int64_t>();
+	TestRoundTrip<uint64_t>();
+	TestAutoIsSmallest();
+
+	return TEST_RESULT();
+}
@@ -0,0 +1,111 @@
+﻿//
+// filecolumn_test.cpp
+//
+// Copyright (c) 2024 Izadori
+//
+// This software is released under the MIT License.
+// http://opensource.org/licenses/mit-license.php
+//
+
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "collector.h"
+#include "filecolumn.h"
+#include "finder.h"
+#include "test.h"
+
+//-----------------------------------------------------------------------------------------
+// AsyncFileColumn<>のテスト
+//-----------------------------------------------------------------------------------------
+
+// 行数は分かるが、一度しか読めない入力範囲として扱う（位置を指定して読まない）
+static_assert(HasSize<AsyncFileColumn<int>>::value);
+static_assert(!IsMultiPass<AsyncFileColumn<int>>::value);
+static_assert(!Zipper<AsyncFileColumn<int>, std::vector<int>>::random_access);
+
+static std::string TempPath(const std::string & name)
+{
+	return (std::filesystem::temp_directory_path() / name).string();
+}
+
+static void WriteValues(const std::string & path, const std::vector<int> & values)
+{
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+	file.write((const char *)values.data(), (std::streamsize)(values.size() * sizeof(int)));
+}
+
+void TestRead()
+{
+	std::string path = TempPath("izadori_filecolumn_test.bin");
+	std::vector<int> values(100003);
+
+	for(size_t i = 0; i < values.size(); i++)
+	{
+		values[i] = (int)(i * 3);
+	}
+
+	WriteValues(path, values);
+
+	{
+		// ブロックの境界が行の途中にならない大きさに切り詰め、3つのブロックを先読みする
+		AsyncFileColumn<int> column(path, 4096 + 2, 3);
+		std::vector<int> output;
+
+		CHECK(column.size() == values.size());
+		CollectInto(Zip(output), Zip(column));
+		CHECK(output == values);
+	}
+
+	{
+		AsyncFileColumn<int> column(path, 1 << 12);
+		CHECK(Equal(Zip(column, values)));
+	}
+
+	std::filesystem::remove(path);
+}
+
+// begin()は一度だけ呼び出せる（読み込み中の他のイテレータを無効にしない）
+void TestSingleBegin()
+{
+	std::string path = TempPath("izadori_filecolumn_begin.bin");
+	std::vector<int> values{1, 2, 3, 4, 5};
+	bool thrown = false;
+
+	WriteValues(path, values);
+
+	{
+		AsyncFileColumn<int> column(path);
+		int sum = 0;
+
+		for(auto x : column)
+		{
+			sum += x;
+		}
+
+		CHECK(sum == 15);
+
+		try
+		{
+			column.begin();
+		}
+		catch(const std::logic_error &)
+		{
+			thrown = true;
+		}
+	}
+
+	CHECK(thrown);
+	std::filesystem::remove(path);
+}
+
+int main()
+{
+	TestRead();
+	TestSingleBegin();
+
+	return TEST_RESULT();
+}
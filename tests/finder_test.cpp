@@ -0,0 +1,84 @@
+﻿//
+// finder_test.cpp
+//
+// Copyright (c) 2024 Izadori
+//
+// This software is released under the MIT License.
+// http://opensource.org/licenses/mit-license.php
+//
+
+#include <thread>
+#include <vector>
+
+#include "finder.h"
+#include "ringbuffer.h"
+#include "test.h"
+
+//-----------------------------------------------------------------------------------------
+// Mismatch()・Equal()のテスト
+//-----------------------------------------------------------------------------------------
+
+using Ring = SpscRingBuffer<int>;
+
+// 別スレッドでvaluesを書き込む
+std::thread Produce(Ring & ring, std::vector<int> values)
+{
+	return std::thread([&ring, values]() {
+		for(int value : values)
+		{
+			ring.Push(value);
+		}
+
+		ring.Close();
+	});
+}
+
+void TestEqual()
+{
+	std::vector<int> a{1, 2, 3, 4}, b{1, 2, 3, 4}, c{1, 2, 9, 4}, d{1, 2, 3};
+
+	CHECK(Equal(Zip(a, b)));
+	CHECK(!Equal(Zip(a, c)));
+	CHECK(!Equal(Zip(a, d)));
+	CHECK(!Equal(Zip(d, a)));
+	CHECK(Mismatch(Zip(a, c)) == 2);
+	CHECK(Mismatch(Zip(a, b)) == a.size());
+}
+
+// 一度しか読めない列は要素数を数えずに、読みながら比較する
+void TestEqualRing()
+{
+	std::vector<int> a{1, 2, 3, 4};
+
+	for(auto & [values, expected] : std::vector<std::pair<std::vector<int>, bool>>{
+		{{1, 2, 3, 4}, true}, {{1, 2, 3}, false}, {{1, 2, 3, 4, 5}, false}, {{1, 5, 3, 4}, false}, {{}, false}})
+	{
+		Ring ring(2);
+		std::thread producer = Produce(ring, values);
+
+		CHECK(Equal(Zip(a, ring)) == expected);
+
+		// 残りを読み切ってから合流する
+		for(auto value : ring)
+		{
+			(void)value;
+		}
+
+		producer.join();
+	}
+
+	Ring ring1(2), ring2(2);
+	std::thread producer1 = Produce(ring1, {5, 6, 7}), producer2 = Produce(ring2, {5, 6, 7});
+
+	CHECK(Equal(Zip(ring1, ring2)));
+	producer1.join();
+	producer2.join();
+}
+
+int main()
+{
+	TestEqual();
+	TestEqualRing();
+
+	return TEST_RESULT();
+}
@@ -0,0 +1,78 @@
+﻿//
+// hasher_test.cpp
+//
+// Copyright (c) 2024 Izadori
+//
+// This software is released under the MIT License.
+// http://opensource.org/licenses/mit-license.php
+//
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "bitcolumn.h"
+#include "hasher.h"
+#include "test.h"
+
+//-----------------------------------------------------------------------------------------
+// HashRows()のテスト
+//-----------------------------------------------------------------------------------------
+
+// 参照がプロキシの列（BitColumn・std::vector<bool>）は値と同じハッシュ値になる
+void TestHashProxyColumns()
+{
+	std::vector<int> keys(300);
+	std::vector<bool> flags(300);
+	std::vector<std::string> names(300);
+	BitColumn bits(300);
+
+	for(int i = 0; i < 300; i++)
+	{
+		keys[i] = i / 2;
+		flags[i] = i % 3 == 0;
+		bits[i] = i % 3 == 0;
+		names[i] = std::to_string(i % 5);
+	}
+
+	std::vector<uint64_t> from_bits, from_flags, serial;
+
+	HashRows(Zip(keys, bits, names), from_bits, 4);
+	HashRows(Zip(keys, flags, names), from_flags);
+	HashRows(Zip(keys, bits, names), serial);
+
+	CHECK(from_bits.size() == 300);
+	CHECK(from_bits == from_flags);
+	CHECK(from_bits == serial);
+
+	// 同じ値の行は同じハッシュ値、異なる値の行は（ほぼ確実に）異なるハッシュ値
+	CHECK(from_bits[0] != from_bits[1]);
+
+	std::vector<int> same_keys{7, 7};
+	BitColumn same_bits(2);
+	std::vector<uint64_t> same;
+
+	same_bits[0] = true;
+	same_bits[1] = true;
+	HashRows(Zip(same_keys, same_bits), same);
+	CHECK(same[0] == same[1]);
+}
+
+// 0.0と-0.0は同じハッシュ値
+void TestHashFloatingPoint()
+{
+	std::vector<double> values{0.0, -0.0, 1.5};
+	std::vector<uint64_t> hashes;
+
+	HashRows(Zip(values), hashes);
+	CHECK(hashes[0] == hashes[1]);
+	CHECK(hashes[0] != hashes[2]);
+}
+
+int main()
+{
+	TestHashProxyColumns();
+	TestHashFloatingPoint();
+
+	return TEST_RESULT();
+}
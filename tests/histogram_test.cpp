@@ -0,0 +1,100 @@
+﻿//
+// histogram_test.cpp
+//
+// Copyright (c) 2024 Izadori
+//
+// This software is released under the MIT License.
+// http://opensource.org/licenses/mit-license.php
+//
+
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+#include "histogram.h"
+#include "test.h"
+
+//-----------------------------------------------------------------------------------------
+// UniformBins・EdgeBins・Histogram()のテスト
+//-----------------------------------------------------------------------------------------
+
+void TestUniformBins()
+{
+	UniformBins bins(0.0, 10.0, 5);
+
+	CHECK(bins.size() == 5);
+	CHECK(bins.Index(0.0) == 0);
+	CHECK(bins.Index(3.9) == 1);
+	CHECK(bins.Index(10.0) == 4);
+	CHECK(bins.Index(-0.1) == 5);
+	CHECK(bins.Index(10.1) == 5);
+	CHECK(bins.Index(std::nan("")) == 5);
+}
+
+// ビンの位置を計算できない範囲は構築時に拒否する
+void TestUniformBinsInvalid()
+{
+	auto rejects = [](double min, double max, size_t count) {
+		try
+		{
+			UniformBins bins(min, max, count);
+			return false;
+		}
+		catch(const std::invalid_argument &)
+		{
+			return true;
+		}
+	};
+
+	CHECK(rejects(1.0, 1.0, 4));
+	CHECK(rejects(2.0, 1.0, 4));
+	CHECK(rejects(std::nan(""), 1.0, 4));
+	CHECK(rejects(0.0, std::numeric_limits<double>::quiet_NaN(), 4));
+	CHECK(rejects(0.0, 1.0, 0));
+	CHECK(!rejects(0.0, 1.0, 1));
+}
+
+void TestHistogram()
+{
+	std::vector<double> values;
+	std::vector<int> weights;
+
+	for(int i = 0; i < 1000; i++)
+	{
+		values.push_back((i % 23) * 0.5 - 1.0);
+		weights.push_back(i % 3);
+	}
+
+	UniformBins uniform(0.0, 10.0, 4);
+	EdgeBins edges({0.0, 2.5, 5.0, 7.5, 10.0});
+	std::vector<size_t> expected(4, 0);
+	std::vector<int> weighted(4, 0);
+
+	for(size_t i = 0; i < values.size(); i++)
+	{
+		size_t index = uniform.Index(values[i]);
+
+		if(index < 4)
+		{
+			expected[index]++;
+			weighted[index] += weights[i];
+		}
+	}
+
+	for(unsigned int threads : {1u, 3u, 8u})
+	{
+		CHECK(Histogram(values, uniform, threads) == expected);
+		CHECK(Histogram(values, edges, threads) == expected);
+		CHECK(Histogram(Zip(values, weights), uniform, threads) == weighted);
+	}
+}
+
+int main()
+{
+	TestUniformBins();
+	TestUniformBinsInvalid();
+	TestHistogram();
+
+	return TEST_RESULT();
+}
@@ -0,0 +1,176 @@
+﻿//
+// locality_test.cpp
+//
+// Copyright (c) 2024 Izadori
+//
+// This software is released under the MIT License.
+// http://opensource.org/licenses/mit-license.php
+//
+
+#include <atomic>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "locality.h"
+#include "test.h"
+
+//-----------------------------------------------------------------------------------------
+// NumaScheduler・FirstTouch()・NumaParallelFor()・ThreadPool::Wait()のテスト
+//-----------------------------------------------------------------------------------------
+
+static constexpr size_t rows = 1 << 20;
+
+// 各ノードのワーカーだけが行を処理し、呼び出したスレッドは処理しない
+void TestRunOnNodeWorkers()
+{
+	NumaScheduler & scheduler = NumaScheduler::GetDefault();
+	bool has_workers = true;
+
+	for(size_t node = 0; node < scheduler.NodeCount(); node++)
+	{
+		has_workers = has_workers && scheduler.GetPool(node).size() > 0;
+	}
+
+	std::vector<int, FirstTouchAllocator<int>> column(rows);
+	std::vector<int> touched(rows, 0);
+	std::atomic<size_t> by_caller(0);
+	std::thread::id caller = std::this_thread::get_id();
+
+	FirstTouch(scheduler, column, rows, 1);
+
+	NumaParallelFor(scheduler, Zip(column, touched), [&](size_t begin, size_t end) {
+		if(std::this_thread::get_id() == caller)
+		{
+			by_caller += end - begin;
+		}
+
+		for(size_t i = begin; i < end; i++)
+		{
+			touched[i] += column[i];
+		}
+	});
+
+	size_t total = 0;
+
+	for(auto t : touched)
+	{
+		total += t == 1 ? 1 : 0;
+	}
+
+	CHECK(total == rows);
+
+	if(has_workers)
+	{
+		CHECK(by_caller == 0);
+	}
+}
+
+// ノードが1つの場合は既定のThreadPoolを使い、ワーカーを増やさない
+void TestSingleNode()
+{
+	NumaScheduler single(NumaScheduler::Topology{{3, {0}}});
+
+	CHECK(single.NodeCount() == 1);
+	CHECK(&single.GetPool(0) == &ThreadPool::GetDefault());
+	CHECK(single.NodeIndex(3) == 0);
+
+	NumaScheduler unknown(NumaScheduler::Topology{});
+
+	CHECK(unknown.NodeCount() == 1);
+	CHECK(&unknown.GetPool(0) == &ThreadPool::GetDefault());
+	CHECK(unknown.NodeIndex(0) == -1);
+
+	if(NumaScheduler::GetDefault().NodeCount() == 1)
+	{
+		CHECK(&NumaScheduler::GetDefault().GetPool(0) == &ThreadPool::GetDefault());
+	}
+}
+
+// ノードIDが飛んでいる場合やCPUのないノードがある場合も、ノードIDをプールの番号に対応させる
+void TestSparseNodeIds()
+{
+	NumaScheduler scheduler(NumaScheduler::Topology{{0, {0}}, {1, {}}, {4, {0}}});
+
+	CHECK(scheduler.NodeCount() == 2);
+	CHECK(scheduler.NodeIndex(0) == 0);
+	CHECK(scheduler.NodeIndex(1) == -1);
+	CHECK(scheduler.NodeIndex(4) == 1);
+	CHECK(scheduler.NodeIndex(5) == -1);
+	CHECK(scheduler.NodeIndex(-1) == -1);
+
+	std::vector<int> column(rows);
+	int node = scheduler.NodeOf(column.data());
+	CHECK(node == -1 || (size_t)node < scheduler.NodeCount());
+
+	// 各ノードのプールで全ての行を1回ずつ処理する
+	std::vector<int> touched(rows, 0);
+
+	NumaParallelFor(scheduler, Zip(column, touched), [&](size_t begin, size_t end) {
+		for(size_t i = begin; i < end; i++)
+		{
+			touched[i]++;
+		}
+	});
+
+	size_t total = 0;
+
+	for(auto t : touched)
+	{
+		total += t == 1 ? 1 : 0;
+	}
+
+	CHECK(total == rows);
+}
+
+// Wait()はタスクを実行せずに完了を待ち、最初の例外を再送出する
+void TestWait()
+{
+	ThreadPool pool(2);
+	std::thread::id caller = std::this_thread::get_id();
+	std::atomic<int> count(0), by_caller(0);
+
+	for(int r = 0; r < 100; r++)
+	{
+		ThreadPool::TaskGroup group;
+
+		for(int i = 0; i < 16; i++)
+		{
+			pool.Spawn(group, [&]() {
+				count++;
+				by_caller += std::this_thread::get_id() == caller ? 1 : 0;
+			});
+		}
+
+		pool.Wait(group);
+	}
+
+	CHECK(count == 1600);
+	CHECK(by_caller == 0);
+
+	ThreadPool::TaskGroup group;
+	bool thrown = false;
+
+	pool.Spawn(group, []() { throw std::runtime_error("error"); });
+
+	try
+	{
+		pool.Wait(group);
+	}
+	catch(const std::runtime_error &)
+	{
+		thrown = true;
+	}
+
+	CHECK(thrown);
+}
+
+int main()
+{
+	TestRunOnNodeWorkers();
+	TestSingleNode();
+	TestSparseNodeIds();
+	TestWait();
+
+	return TEST_RESULT();
+}
@@ -0,0 +1,198 @@
+﻿//
+// nullable_test.cpp
+//
+// Copyright (c) 2024 Izadori
+//
+// This software is released under the MIT License.
+// http://opensource.org/licenses/mit-license.php
+//
+
+#include <optional>
+#include <stdexcept>
+#include <tuple>
+#include <vector>
+
+#include "nullable.h"
+#include "parallel.h"
+#include "threadpool.h"
+#include "test.h"
+
+//-----------------------------------------------------------------------------------------
+// Nullable<>・MaskedSum()/MaskedMin()/MaskedMax()のテスト
+//-----------------------------------------------------------------------------------------
+
+void TestReference()
+{
+	Nullable<std::vector<int>> column(std::vector<std::optional<int>>{1, std::nullopt, 3});
+
+	CHECK(column.size() == 3 && column.NullCount() == 1);
+	CHECK(column[0].has_value() && *column[0] == 1);
+	CHECK(!column[1] && column[1].value_or(-1) == -1);
+
+	bool thrown = false;
+
+	try
+	{
+		column[1].value();
+	}
+	catch(const std::bad_optional_access &)
+	{
+		thrown = true;
+	}
+
+	CHECK(thrown);
+
+	// 値・欠損値・std::optional<>・他の行の参照を代入できる
+	column[1] = 20;
+	CHECK(column[1] && *column[1] == 20);
+
+	column[0] = std::nullopt;
+	CHECK(!column[0]);
+
+	column[0] = std::optional<int>(7);
+	CHECK(column[0] && *column[0] == 7);
+
+	column[2] = column[0];
+	CHECK(column[2] && *column[2] == 7);
+
+	column[2] = column[0] = std::nullopt;
+	CHECK(!column[2] && column.NullCount() == 2);
+
+	std::optional<int> value = column[1];
+	CHECK(value && *value == 20);
+}
+
+// Zip()した他の列と合わせて、各行をstd::optional<>のように読み書きする
+void TestZip()
+{
+	std::vector<double> prices{1.5, 2.0, 4.0};
+	Nullable<std::vector<int>> quantities(std::vector<std::optional<int>>{2, std::nullopt, 3});
+	double total = 0;
+
+	for(auto [price, quantity] : Zip(prices, quantities))
+	{
+		if(quantity)
+		{
+			total += price * *quantity;
+		}
+	}
+
+	CHECK(total == 15.0);
+
+	for(auto [price, quantity] : Zip(prices, quantities))
+	{
+		quantity = price > 1.8 ? std::optional<int>((int)price) : std::nullopt;
+	}
+
+	CHECK(!quantities[0] && *quantities[1] == 2 && *quantities[2] == 4);
+}
+
+void TestMaskedReduce()
+{
+	Nullable<std::vector<double>> column;
+
+	CHECK(!MaskedMin(column) && !MaskedMax(column) && MaskedSum(column) == 0);
+
+	double sum = 0;
+
+	// 全て有効なワード・一部が有効なワード・全て欠損値のワード・末尾の不完全なワード
+	for(int i = 0; i < 250; i++)
+	{
+		bool valid = i < 64 || (i < 128 && i % 3 == 0) || i >= 192;
+
+		if(valid)
+		{
+			column.push_back((double)(i - 100));
+			sum += i - 100;
+		}
+		else
+		{
+			column.push_back(std::nullopt);
+		}
+	}
+
+	CHECK(MaskedSum(column) == sum);
+	CHECK(*MaskedMin(column) == -100);
+	CHECK(*MaskedMax(column) == 149);
+
+	Nullable<std::vector<int>> empty(std::vector<std::optional<int>>(100, std::nullopt));
+
+	CHECK(!MaskedMin(empty) && !MaskedMax(empty) && MaskedSum(empty) == 0);
+}
+
+// 64バイト境界から16バイトずれた位置を指すcharの列
+struct OffsetBytes
+{
+	char * first;
+	size_t count;
+
+	char * data()
+	{
+		return first;
+	}
+
+	char * begin()
+	{
+		return first;
+	}
+
+	char * end()
+	{
+		return first + count;
+	}
+
+	size_t size() const
+	{
+		return count;
+	}
+};
+
+// 有効ビットマップのワードの途中で区間を分けない（Nullable<>の有効ビットマップも境界に含める）
+void TestRowAlignment()
+{
+	constexpr size_t rows = 100000;
+
+	std::vector<char, CacheAlignedAllocator<char>> buffer(rows + 16);
+	OffsetBytes bytes{buffer.data() + 16, rows};
+	Nullable<std::vector<double>> column;
+
+	column.resize(rows);
+
+	RowAlignment alignment = GetRowAlignment(Zip(bytes, column));
+	CHECK(alignment.phase % BitColumn::word_bits == 0);
+	CHECK(alignment.period % BitColumn::word_bits == 0);
+
+	// ハードウェアのスレッド数によらず、ワーカーのスレッドで並列に書き込む
+	ThreadPool pool(4);
+	auto zipper = Zip(bytes, column);
+
+	ParallelFor(pool, rows, [&zipper](size_t begin, size_t end, unsigned int) {
+		for(size_t i = begin; i < end; i++)
+		{
+			auto [byte, value] = zipper[i];
+			value = i % 5 == 0 ? std::optional<double>((double)i) : std::nullopt;
+			byte = 1;
+		}
+	}, 16, alignment);
+
+	CHECK(column.NullCount() == rows - (rows + 4) / 5);
+
+	Nullable<std::vector<double>> flags;
+
+	flags.resize(rows);
+	ParallelForEach(Zip(bytes, flags), [](auto row) {
+		std::get<1>(row) = (double)std::get<0>(row);
+	});
+
+	CHECK(flags.NullCount() == 0);
+}
+
+int main()
+{
+	TestReference();
+	TestZip();
+	TestMaskedReduce();
+	TestRowAlignment();
+
+	return TEST_RESULT();
+}
@@ -0,0 +1,96 @@
+﻿//
+// openmp_benchmark.cpp
+//
+// Copyright (c) 2024 Izadori
+//
+// This software is released under the MIT License.
+// http://opensource.org/licenses/mit-license.php
+//
+
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+#include <omp.h>
+
+#include "enumerator.h"
+#include "zipper.h"
+
+//-----------------------------------------------------------------------------------------
+// Zip()・Enumerate()の逐次処理とOpenMPのparallel forによる並列処理の処理時間を比較する
+//-----------------------------------------------------------------------------------------
+
+static constexpr int rows = 1 << 24;
+static constexpr int repeats = 10;
+
+template <typename Function>
+double Measure(Function func)
+{
+	double best = 0.0;
+
+	for(int r = 0; r < repeats; r++)
+	{
+		auto start = std::chrono::steady_clock::now();
+		func();
+		double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		best = (r == 0 || ms < best) ? ms : best;
+	}
+
+	return best;
+}
+
+int main()
+{
+	std::vector<float> a(rows, 1.5f), b(rows, 2.0f), c(rows);
+	double sum = 0.0;
+
+	double serial = Measure([&]() {
+		for(auto [x, y, z] : Zip(a, b, c))
+		{
+			z = x * y + z;
+		}
+	});
+
+	double parallel = Measure([&]() {
+		#pragma omp parallel for
+		for(auto [x, y, z] : Zip(a, b, c))
+		{
+			z = x * y + z;
+		}
+	});
+
+	std::printf("Zip         serial %8.2f ms  parallel %8.2f ms  (%d threads)\n", serial, parallel, omp_get_max_threads());
+
+	serial = Measure([&]() {
+		for(auto [i, x] : Enumerate(a))
+		{
+			x = (float)(i & 0xff);
+		}
+	});
+
+	parallel = Measure([&]() {
+		#pragma omp parallel for
+		for(auto [i, x] : Enumerate(a))
+		{
+			x = (float)(i & 0xff);
+		}
+	});
+
+	std::printf("Enumerate   serial %8.2f ms  parallel %8.2f ms\n", serial, parallel);
+
+	parallel = Measure([&]() {
+		double s = 0.0;
+
+		#pragma omp parallel for reduction(+ : s)
+		for(auto [x, y] : Zip(a, b))
+		{
+			s += x * y;
+		}
+
+		sum = s;
+	});
+
+	std::printf("Reduction            parallel %8.2f ms  (sum = %.0f)\n", parallel, sum);
+
+	return 0;
+}
@@ -0,0 +1,171 @@
+﻿//
+// openmp_test.cpp
+//
+// Copyright (c) 2024 Izadori
+//
+// This software is released under the MIT License.
+// http://opensource.org/licenses/mit-license.php
+//
+
+#include <algorithm>
+#include <iterator>
+#include <list>
+#include <type_traits>
+#include <vector>
+
+#include "enumerator.h"
+#include "zipper.h"
+#include "test.h"
+
+//-----------------------------------------------------------------------------------------
+// Zip()・Enumerate()をOpenMPのparallel forで並列化するテスト
+//-----------------------------------------------------------------------------------------
+
+static constexpr int rows = 1 << 20;
+
+// parallel forにはランダムアクセスイテレータが必要
+static_assert(std::is_same_v<std::iterator_traits<Zipper<std::vector<int>, std::vector<double>>::Iterator>::iterator_category, std::random_access_iterator_tag>);
+static_assert(std::is_same_v<std::iterator_traits<Zipper<std::vector<int>, std::list<int>>::Iterator>::iterator_category, std::forward_iterator_tag>);
+
+// 各行に書き込む
+void TestZipWrite()
+{
+	std::vector<int> a(rows), b(rows);
+	std::vector<long long> c(rows, -1);
+
+	for(int i = 0; i < rows; i++)
+	{
+		a[i] = i;
+		b[i] = 2 * i;
+	}
+
+	#pragma omp parallel for
+	for(auto [x, y, z] : Zip(a, b, c))
+	{
+		z = (long long)x + y;
+	}
+
+	bool ok = true;
+
+	for(int i = 0; i < rows; i++)
+	{
+		ok = ok && c[i] == 3LL * i;
+	}
+
+	CHECK(ok);
+}
+
+// 長さの異なる列は最も短い列の長さだけ処理する
+void TestZipShortest()
+{
+	std::vector<int> a(rows, 1), b(rows / 2, 0);
+
+	#pragma omp parallel for
+	for(auto [x, y] : Zip(a, b))
+	{
+		y = x;
+	}
+
+	CHECK(std::count(b.begin(), b.end(), 1) == rows / 2);
+	CHECK(Zip(a, b).end() - Zip(a, b).begin() == rows / 2);
+}
+
+// reduction節を使って集計する
+void TestZipReduction()
+{
+	std::vector<int> a(rows, 3), b(rows, 5);
+	long long sum = 0;
+
+	#pragma omp parallel for reduction(+ : sum)
+	for(auto [x, y] : Zip(a, b))
+	{
+		sum += (long long)x * y;
+	}
+
+	CHECK(sum == 15LL * rows);
+}
+
+// インデックスが行と対応する
+void TestEnumerate()
+{
+	std::vector<int> a(rows, 0);
+
+	#pragma omp parallel for
+	for(auto [i, x] : Enumerate(a, 10, 3))
+	{
+		x = i;
+	}
+
+	bool ok = true;
+
+	for(int i = 0; i < rows; i++)
+	{
+		ok = ok && a[i] == 10 + 3 * i;
+	}
+
+	CHECK(ok);
+}
+
+void TestEnumerateZip()
+{
+	std::vector<int> a(rows, 0), b(rows, 0);
+
+	#pragma omp parallel for
+	for(auto [i, t] : Enumerate(Zip(a, b)))
+	{
+		auto & [x, y] = t;
+		x = i;
+		y = -i;
+	}
+
+	bool ok = true;
+
+	for(int i = 0; i < rows; i++)
+	{
+		ok = ok && a[i] == i && b[i] == -i;
+	}
+
+	CHECK(ok);
+}
+
+// 読み取りのみの標準アルゴリズムに渡せる
+void TestAlgorithms()
+{
+	std::vector<int> a{1, 2, 3, 4, 5};
+	std::vector<char> b{'a', 'b', 'c', 'd', 'e'};
+	auto zipper = Zip(a, b);
+
+	auto it = std::find_if(zipper.begin(), zipper.end(), [](auto t) { return std::get<1>(t) == 'c'; });
+	CHECK(it - zipper.begin() == 2);
+	CHECK(std::get<0>(*it) == 3);
+	CHECK(std::count_if(zipper.begin(), zipper.end(), [](auto t) { return std::get<0>(t) % 2 == 1; }) == 3);
+	CHECK(std::distance(zipper.begin(), zipper.end()) == 5);
+}
+
+// ランダムアクセスできない列を含む場合も順に走査できる
+void TestForwardOnly()
+{
+	std::vector<int> a{1, 2, 3};
+	std::list<int> b{10, 20, 30, 40};
+	int sum = 0;
+
+	for(auto [x, y] : Zip(a, b))
+	{
+		sum += x * y;
+	}
+
+	CHECK(sum == 140);
+}
+
+int main()
+{
+	TestZipWrite();
+	TestZipShortest();
+	TestZipReduction();
+	TestEnumerate();
+	TestEnumerateZip();
+	TestAlgorithms();
+	TestForwardOnly();
+
+	return TEST_RESULT();
+}
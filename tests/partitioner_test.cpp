@@ -0,0 +1,82 @@
+﻿//
+// partitioner_test.cpp
+//
+// Copyright (c) 2024 Izadori
+//
+// This software is released under the MIT License.
+// http://opensource.org/licenses/mit-license.php
+//
+
+#include <functional>
+#include <stdexcept>
+#include <vector>
+
+#include "partitioner.h"
+#include "test.h"
+
+//-----------------------------------------------------------------------------------------
+// Partition()のテスト
+//-----------------------------------------------------------------------------------------
+
+// 各パーティションに同じ番号の行が入力順に並ぶ
+void TestPartition()
+{
+	std::vector<int> keys(1000), payload(1000);
+
+	for(int i = 0; i < 1000; i++)
+	{
+		keys[i] = (i * 7919) % 1013;
+		payload[i] = i;
+	}
+
+	auto hash = [](int key) { return (size_t)key; };
+
+	for(size_t num_parts : {1, 3, 8, 100})
+	{
+		for(unsigned int threads : {1u, 4u})
+		{
+			std::vector<int> out_keys{-1}, out_payload{-1};
+			auto offsets = Partition(Zip(keys, payload), num_parts, hash, Zip(out_keys, out_payload), threads);
+			bool ok = offsets.size() == num_parts + 1 && offsets.front() == 1 && offsets.back() == 1001;
+
+			for(size_t p = 0; ok && p < num_parts; p++)
+			{
+				for(size_t i = offsets[p]; ok && i < offsets[p + 1]; i++)
+				{
+					ok = (size_t)out_keys[i] % num_parts == p && keys[out_payload[i]] == out_keys[i];
+					ok = ok && (i == offsets[p] || out_payload[i - 1] < out_payload[i]);
+				}
+			}
+
+			CHECK(ok);
+			CHECK(out_keys[0] == -1);
+		}
+	}
+}
+
+// パーティション数0は処理する前に拒否する
+void TestPartitionZero()
+{
+	std::vector<int> keys{1, 2, 3}, output;
+	bool thrown = false;
+
+	try
+	{
+		Partition(Zip(keys), 0, std::hash<int>(), Zip(output));
+	}
+	catch(const std::invalid_argument &)
+	{
+		thrown = true;
+	}
+
+	CHECK(thrown);
+	CHECK(output.empty());
+}
+
+int main()
+{
+	TestPartition();
+	TestPartitionZero();
+
+	return TEST_RESULT();
+}
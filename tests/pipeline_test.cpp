@@ -0,0 +1,149 @@
+﻿//
+// pipeline_test.cpp
+//
+// Copyright (c) 2024 Izadori
+//
+// This software is released under the MIT License.
+// http://opensource.org/licenses/mit-license.php
+//
+
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+#include "enumerator.h"
+#include "pipeline.h"
+#include "test.h"
+
+//-----------------------------------------------------------------------------------------
+// BoundedQueue<>・Pipeline()のテスト
+//-----------------------------------------------------------------------------------------
+
+// 容量は2のべき乗に切り上げ、満杯・空の場合はfalseを返す
+void TestBoundedQueue()
+{
+	BoundedQueue<int> queue(3);
+	int item = 0;
+
+	CHECK(queue.capacity() == 4);
+
+	for(int i = 0; i < 4; i++)
+	{
+		CHECK(queue.TryPush(int(i)));
+	}
+
+	CHECK(!queue.TryPush(4));
+	CHECK(queue.TryPop(item) && item == 0);
+	CHECK(queue.TryPush(4));
+
+	for(int i = 1; i <= 4; i++)
+	{
+		CHECK(queue.TryPop(item) && item == i);
+	}
+
+	CHECK(!queue.TryPop(item));
+}
+
+// 複数のスレッドで処理して順番が前後しても、Sinkには元の順番で渡る
+void TestReorder()
+{
+	std::vector<int> values(2000);
+
+	for(int i = 0; i < 2000; i++)
+	{
+		values[i] = i;
+	}
+
+	std::vector<long long> output;
+
+	Pipeline(Enumerate(values), 7, 4)
+		| Stage([](auto row) {
+			// まとまりごとに処理時間を変えて、後のまとまりが先に終わるようにする
+			if(std::get<0>(row) % 49 == 0)
+			{
+				std::this_thread::sleep_for(std::chrono::microseconds(200 * (std::get<0>(row) % 3)));
+			}
+
+			return (long long)std::get<1>(row) * 2;
+		}, 4)
+		| Stage([](long long x) { return x + 1; }, 3)
+		| Sink([&output](long long x) { output.push_back(x); });
+
+	bool ordered = output.size() == values.size();
+
+	for(size_t i = 0; ordered && i < output.size(); i++)
+	{
+		ordered = output[i] == (long long)i * 2 + 1;
+	}
+
+	CHECK(ordered);
+
+	// 参照を返す範囲は要素へのポインタを受け渡し、ステージなしでも順番を保つ
+	std::vector<int> copied;
+
+	Pipeline(values, 64) | Sink([&copied](int & x) { copied.push_back(x); });
+	CHECK(copied == values);
+}
+
+// ステージやSinkの例外はパイプラインを中断して、実行したスレッドで再送出する
+void TestException()
+{
+	std::vector<int> values(100000, 1);
+
+	for(unsigned int threads : {1u, 4u})
+	{
+		bool thrown = false;
+		size_t sunk = 0;
+
+		try
+		{
+			Pipeline(values, 16, 2)
+				| Stage([](int & x) { return x; }, threads)
+				| Stage([](int x) {
+					static thread_local int count = 0;
+
+					if(++count == 500)
+					{
+						count = 0;
+						throw std::runtime_error("stage");
+					}
+
+					return x;
+				}, threads)
+				| Sink([&sunk](int) { sunk++; });
+		}
+		catch(const std::runtime_error &)
+		{
+			thrown = true;
+		}
+
+		CHECK(thrown);
+		CHECK(sunk < values.size());
+	}
+
+	bool thrown = false;
+
+	try
+	{
+		Pipeline(values, 16, 2)
+			| Stage([](int & x) { return x; }, 2)
+			| Sink([](int) { throw std::logic_error("sink"); });
+	}
+	catch(const std::logic_error &)
+	{
+		thrown = true;
+	}
+
+	CHECK(thrown);
+}
+
+int main()
+{
+	TestBoundedQueue();
+	TestReorder();
+	TestException();
+
+	return TEST_RESULT();
+}
@@ -0,0 +1,86 @@
+﻿//
+// ranker_test.cpp
+//
+// Copyright (c) 2024 Izadori
+//
+// This software is released under the MIT License.
+// http://opensource.org/licenses/mit-license.php
+//
+
+#include <tuple>
+#include <vector>
+
+#include "ranker.h"
+#include "test.h"
+
+//-----------------------------------------------------------------------------------------
+// ArgMax()・ArgMin()・TopK()のテスト
+//-----------------------------------------------------------------------------------------
+
+// 同じ値が複数ある場合は先頭に近い要素を選ぶ（区間数やレーンの位置によらない）
+void TestArgTies()
+{
+	std::vector<int> values(1000, 5);
+
+	values[3] = 1;
+	values[517] = 1;
+	values[900] = 1;
+	values[40] = 9;
+	values[41] = 9;
+	values[999] = 9;
+
+	for(unsigned int threads : {1u, 2u, 3u, 8u, 64u})
+	{
+		CHECK(ArgMax(Enumerate(values), RankKey(), threads) == 40);
+		CHECK(ArgMin(Enumerate(values), RankKey(), threads) == 3);
+	}
+
+	// 全ての値が同じ場合は先頭
+	std::vector<int> same(100, 2);
+	CHECK(ArgMax(Enumerate(same), RankKey(), 7) == 0);
+	CHECK(ArgMin(Enumerate(same, 10, 2)) == 10);
+
+	std::vector<int> empty;
+	CHECK(!ArgMax(Enumerate(empty)));
+}
+
+// Zipper<>の場合は先頭の列で比較し、結果はEnumerate()のインデックス
+void TestArgZip()
+{
+	std::vector<double> score{0.5, 2.0, 2.0, -1.0};
+	std::vector<char> label{'a', 'b', 'c', 'd'};
+
+	CHECK(ArgMax(Enumerate(Zip(score, label), 100)) == 101);
+	CHECK(ArgMin(Enumerate(Zip(score, label), 100)) == 103);
+}
+
+// 値の大きい順、同じ値は位置の前の順
+void TestTopK()
+{
+	std::vector<int> values{3, 7, 7, 1, 9, 7, 3, 9};
+
+	for(unsigned int threads : {1u, 2u, 3u, 8u})
+	{
+		auto rows = TopK(Enumerate(values), 5, RankKey(), threads);
+		std::vector<int> indices;
+
+		for(auto & row : rows)
+		{
+			indices.push_back(std::get<0>(row));
+		}
+
+		CHECK((indices == std::vector<int>{4, 7, 1, 2, 5}));
+	}
+
+	CHECK(TopK(Enumerate(values), 100).size() == values.size());
+	CHECK(TopK(Enumerate(values), 0).empty());
+}
+
+int main()
+{
+	TestArgTies();
+	TestArgZip();
+	TestTopK();
+
+	return TEST_RESULT();
+}
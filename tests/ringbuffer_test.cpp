@@ -0,0 +1,123 @@
+﻿//
+// ringbuffer_test.cpp
+//
+// Copyright (c) 2024 Izadori
+//
+// This software is released under the MIT License.
+// http://opensource.org/licenses/mit-license.php
+//
+
+#include <iterator>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "collector.h"
+#include "enumerator.h"
+#include "ringbuffer.h"
+#include "zipper.h"
+#include "test.h"
+
+//-----------------------------------------------------------------------------------------
+// SpscRingBuffer<>をZip()・Enumerate()・CollectInto()で読むテスト
+//-----------------------------------------------------------------------------------------
+
+using Ring = SpscRingBuffer<int>;
+
+// 一度しか読めない列を含む場合は入力イテレータとなり、要素数を数えない
+static_assert(std::is_same_v<std::iterator_traits<Zipper<Ring>::Iterator>::iterator_category, std::input_iterator_tag>);
+static_assert(std::is_same_v<std::iterator_traits<Zipper<std::vector<int>, Ring>::Iterator>::iterator_category, std::input_iterator_tag>);
+static_assert(std::is_same_v<std::iterator_traits<Enumerator<Ring>::Iterator>::iterator_category, std::input_iterator_tag>);
+static_assert(!HasSize<Zipper<Ring>>::value);
+static_assert(!HasSize<Enumerator<Ring>>::value);
+static_assert(!HasSize<Enumerator<Zipper<std::vector<int>, Ring>>>::value);
+static_assert(HasSize<Zipper<std::vector<int>>>::value);
+static_assert(HasSize<Enumerator<std::vector<int>>>::value);
+
+// 別スレッドでcount個の値を書き込む
+std::thread Produce(Ring & ring, int count)
+{
+	return std::thread([&ring, count]() {
+		for(int i = 0; i < count; i++)
+		{
+			ring.Push(i);
+		}
+
+		ring.Close();
+	});
+}
+
+void TestCollectInto()
+{
+	Ring ring(4, 2);
+	std::vector<int> output;
+	std::thread producer = Produce(ring, 10);
+
+	CollectInto(Zip(output), Zip(ring));
+	producer.join();
+
+	CHECK(output.size() == 10 && output[0] == 0 && output[9] == 9);
+}
+
+void TestZipAndEnumerate()
+{
+	Ring ring(8);
+	std::vector<int> ids{10, 20, 30, 40, 50};
+	std::thread producer = Produce(ring, 100);
+	int rows = 0, sum = 0;
+
+	for(auto [i, t] : Enumerate(Zip(ids, ring)))
+	{
+		auto [id, value] = t;
+		CHECK(id == 10 * (i + 1));
+		CHECK(value == i);
+		sum += value;
+		rows++;
+	}
+
+	// 残りを読み切る
+	for(auto value : ring)
+	{
+		sum += value;
+	}
+
+	producer.join();
+
+	CHECK(rows == 5);
+	CHECK(sum == 4950);
+}
+
+// 先に終端に達した列があれば、他の列の次の要素を待たない
+void TestZipStopsAtFirstEnd()
+{
+	Ring a(8), b(8);
+	int rows = 0;
+
+	for(int i = 0; i < 3; i++)
+	{
+		a.Push(i);
+		b.Push(i * 10);
+	}
+
+	a.Close();
+	b.Flush();
+
+	// bはClose()していないため、bの終端を確認すると4個目の要素を待ち続ける
+	for(auto [x, y] : Zip(a, b))
+	{
+		CHECK(y == x * 10);
+		rows++;
+	}
+
+	CHECK(rows == 3);
+	b.Close();
+}
+
+int main()
+{
+	TestCollectInto();
+	TestZipAndEnumerate();
+	TestZipStopsAtFirstEnd();
+
+	return TEST_RESULT();
+}
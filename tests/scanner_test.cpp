@@ -0,0 +1,96 @@
+﻿//
+// scanner_test.cpp
+//
+// Copyright (c) 2024 Izadori
+//
+// This software is released under the MIT License.
+// http://opensource.org/licenses/mit-license.php
+//
+
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "enumerator.h"
+#include "scanner.h"
+#include "test.h"
+
+//-----------------------------------------------------------------------------------------
+// InclusiveScan()・ExclusiveScan()のテスト
+//-----------------------------------------------------------------------------------------
+
+// 並列版は区間数によらず逐次版と同じ結果になる
+//   区間の境界はキャッシュラインに揃えるため、行数が少ないと空の区間ができる
+void TestScanSizes()
+{
+	for(size_t size : {0, 1, 5, 16, 17, 100, 1000})
+	{
+		std::vector<int> a(size), b(size);
+
+		for(size_t i = 0; i < size; i++)
+		{
+			a[i] = (int)(i % 7) + 1;
+			b[i] = (int)(i % 3);
+		}
+
+		auto transform = [](auto row) { return (long long)std::get<0>(row) * std::get<1>(row); };
+		std::vector<long long> inclusive, exclusive;
+
+		InclusiveScan(Zip(a, b), inclusive, transform);
+		ExclusiveScan(Zip(a, b), exclusive, 10LL, transform);
+
+		long long sum = 0;
+		bool ok = inclusive.size() == size && exclusive.size() == size;
+
+		for(size_t i = 0; ok && i < size; i++)
+		{
+			ok = exclusive[i] == 10 + sum;
+			sum += (long long)a[i] * b[i];
+			ok = ok && inclusive[i] == sum;
+		}
+
+		CHECK(ok);
+
+		for(unsigned int threads : {1u, 2u, 3u, 8u, 64u})
+		{
+			std::vector<long long> pi, pe;
+
+			InclusiveScan(Zip(a, b), pi, transform, std::plus<>(), threads);
+			ExclusiveScan(Zip(a, b), pe, 10LL, transform, std::plus<>(), threads);
+
+			CHECK(pi == inclusive);
+			CHECK(pe == exclusive);
+		}
+	}
+}
+
+// 結合則を満たすが交換則を満たさない演算でも順序を保つ
+void TestScanOrder()
+{
+	std::vector<char> letters;
+
+	for(int i = 0; i < 40; i++)
+	{
+		letters.push_back((char)('a' + i % 26));
+	}
+
+	auto transform = [](auto row) { return std::string(1, std::get<1>(row)); };
+	std::vector<std::string> serial, parallel;
+
+	InclusiveScan(Enumerate(letters), serial, transform);
+	InclusiveScan(Enumerate(letters), parallel, transform, std::plus<>(), 8);
+
+	CHECK(serial == parallel);
+	CHECK(serial.back().size() == 40 && serial.back().substr(0, 3) == "abc");
+
+	ExclusiveScan(Enumerate(letters), parallel, std::string(">"), transform, std::plus<>(), 8);
+	CHECK(parallel[0] == ">" && parallel[3] == ">abc");
+}
+
+int main()
+{
+	TestScanSizes();
+	TestScanOrder();
+
+	return TEST_RESULT();
+}
@@ -0,0 +1,126 @@
+﻿//
+// selected_test.cpp
+//
+// Copyright (c) 2024 Izadori
+//
+// This software is released under the MIT License.
+// http://opensource.org/licenses/mit-license.php
+//
+
+#include <cstdint>
+#include <vector>
+
+#include "enumerator.h"
+#include "test.h"
+
+//-----------------------------------------------------------------------------------------
+// EnumerateSelected()のテスト
+//-----------------------------------------------------------------------------------------
+
+// 全ビットが1のワード・一部が1のワード・0のワード・範囲外のビットを含むBitMask
+void TestBitMask()
+{
+	std::vector<int> values(200);
+	std::vector<uint64_t> words{~uint64_t(0), ~uint64_t(0) ^ 0x8001, 0, ~uint64_t(0)};
+	BitMask mask(words, 256);
+
+	for(int i = 0; i < 200; i++)
+	{
+		values[i] = i;
+	}
+
+	std::vector<int> expected, iterated, visited;
+
+	for(int i = 0; i < 200; i++)
+	{
+		if((words[i / 64] >> (i % 64)) & 1)
+		{
+			expected.push_back(i);
+		}
+	}
+
+	for(auto [i, x] : EnumerateSelected(values, mask))
+	{
+		CHECK(i == x);
+		iterated.push_back(i);
+	}
+
+	EnumerateSelected(values, mask).ForEach([&](int i, int & x) {
+		CHECK(i == x);
+		visited.push_back(i);
+	});
+
+	CHECK(iterated == expected);
+	CHECK(visited == expected);
+}
+
+// 範囲外のインデックスを含む選択ベクトル
+void TestIndices()
+{
+	std::vector<int> a{10, 20, 30}, b{1, 2, 3, 4};
+	std::vector<int> indices{0, 2, 3, 100};
+	int count = 0, sum = 0;
+
+	for(auto [i, t] : EnumerateSelected(Zip(a, b), indices))
+	{
+		auto [x, y] = t;
+		count++;
+		sum += x * y;
+		CHECK(i == 0 || i == 2);
+	}
+
+	CHECK(count == 2);
+	CHECK(sum == 100);
+
+	count = 0;
+	EnumerateSelected(a, indices).ForEach([&](int, int &) { count++; });
+	CHECK(count == 2);
+}
+
+// 一時オブジェクトの選択ベクトルは値として保持する
+void TestTemporaryIndices()
+{
+	std::vector<int> values{10, 20, 30, 40};
+	int sum = 0;
+
+	for(auto [i, x] : EnumerateSelected(values, std::vector<size_t>{1, 3}))
+	{
+		CHECK(i == 1 || i == 3);
+		sum += x;
+	}
+
+	CHECK(sum == 60);
+
+	sum = 0;
+
+	for(auto [i, t] : EnumerateSelected(Zip(values), std::vector<size_t>{0, 2}))
+	{
+		(void)i;
+		sum += std::get<0>(t);
+	}
+
+	CHECK(sum == 40);
+}
+
+void TestRowRanges()
+{
+	std::vector<int> values(100, 1);
+	RowRanges ranges;
+	int sum = 0;
+
+	ranges.Add(5, 10);
+	ranges.Add(90, 120);
+
+	EnumerateSelected(values, ranges).ForEach([&](int, int & x) { sum += x; });
+	CHECK(sum == 15);
+}
+
+int main()
+{
+	TestBitMask();
+	TestIndices();
+	TestTemporaryIndices();
+	TestRowRanges();
+
+	return TEST_RESULT();
+}
@@ -0,0 +1,37 @@
+﻿//
+// test.h
+//
+// Copyright (c) 2024 Izadori
+//
+// This software is released under the MIT License.
+// http://opensource.org/licenses/mit-license.php
+//
+
+#ifndef __IZADORI_TEST_H__
+#define __IZADORI_TEST_H__
+
+#include <cstdio>
+
+//-----------------------------------------------------------------------------------------
+// テスト用の簡単なマクロ
+//   CHECK()が失敗しても処理を続け、TEST_RESULT()で失敗の有無を終了コードとして返す
+//-----------------------------------------------------------------------------------------
+inline int & TestFailures()
+{
+	static int failures = 0;
+	return failures;
+}
+
+#define CHECK(expr) \
+	do \
+	{ \
+		if(!(expr)) \
+		{ \
+			std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #expr); \
+			TestFailures()++; \
+		} \
+	} while(0)
+
+#define TEST_RESULT() (TestFailures() == 0 ? 0 : 1)
+
+#endif // __IZADORI_TEST_H__
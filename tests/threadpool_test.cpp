@@ -0,0 +1,212 @@
+﻿//
+// threadpool_test.cpp
+//
+// Copyright (c) 2024 Izadori
+//
+// This software is released under the MIT License.
+// http://opensource.org/licenses/mit-license.php
+//
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "threadpool.h"
+#include "test.h"
+
+//-----------------------------------------------------------------------------------------
+// WorkStealingDeque<>・ThreadPoolのテスト
+//-----------------------------------------------------------------------------------------
+
+// 所有者は末尾から（LIFO）、他のスレッドは先頭から（FIFO）取り出す。容量を超えると拡張する
+void TestDeque()
+{
+	WorkStealingDeque<int> deque(4);
+	int item = 0;
+
+	for(int i = 0; i < 10; i++)
+	{
+		deque.Push(i);
+	}
+
+	CHECK(deque.Take(item) && item == 9);
+	CHECK(deque.Steal(item) && item == 0);
+	CHECK(deque.Steal(item) && item == 1);
+
+	int count = 0;
+
+	while(deque.Take(item))
+	{
+		count++;
+	}
+
+	CHECK(count == 7);
+	CHECK(!deque.Steal(item));
+}
+
+void TestSpawnSync()
+{
+	for(unsigned int workers : {0u, 1u, 4u})
+	{
+		ThreadPool pool(workers);
+		ThreadPool::TaskGroup group;
+		std::atomic<int> sum(0);
+
+		for(int i = 1; i <= 1000; i++)
+		{
+			pool.Spawn(group, [&sum, i]() { sum += i; });
+		}
+
+		pool.Sync(group);
+		CHECK(sum == 500500);
+
+		// 同じTaskGroupを再び使える
+		pool.Spawn(group, [&sum]() { sum = 0; });
+		pool.Sync(group);
+		CHECK(sum == 0);
+	}
+}
+
+// Wait()は呼び出したスレッドでタスクを実行しない
+void TestWait()
+{
+	ThreadPool pool(2);
+	ThreadPool::TaskGroup group;
+	std::thread::id caller = std::this_thread::get_id();
+	std::atomic<int> on_caller(0), count(0);
+
+	for(int i = 0; i < 100; i++)
+	{
+		pool.Spawn(group, [&]() {
+			on_caller += std::this_thread::get_id() == caller;
+			count++;
+		});
+	}
+
+	pool.Wait(group);
+	CHECK(count == 100);
+	CHECK(on_caller == 0);
+
+	// ワーカーがない場合はSync()と同じく呼び出したスレッドで実行する
+	ThreadPool empty(std::vector<int>{});
+	empty.Spawn(group, [&]() { count++; });
+	empty.Wait(group);
+	CHECK(count == 101);
+}
+
+// ワーカーが自分の両端キューに積んだタスクは他のワーカーが盗んで実行する
+void TestStealing()
+{
+	ThreadPool pool(3);
+	ThreadPool::TaskGroup outer, inner;
+	std::mutex mutex;
+	std::set<std::thread::id> threads;
+
+	pool.Spawn(outer, [&]() {
+		for(int i = 0; i < 64; i++)
+		{
+			pool.Spawn(inner, [&]() {
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+				std::lock_guard<std::mutex> lock(mutex);
+				threads.insert(std::this_thread::get_id());
+			});
+		}
+
+		pool.Sync(inner);
+	});
+
+	pool.Wait(outer);
+	CHECK(threads.size() > 1);
+}
+
+// 入れ子のSync()でスレッドを増やさずに再帰的な分割統治ができる
+static long long Fibonacci(ThreadPool & pool, int n)
+{
+	if(n < 12)
+	{
+		return n < 2 ? n : Fibonacci(pool, n - 1) + Fibonacci(pool, n - 2);
+	}
+
+	ThreadPool::TaskGroup group;
+	long long a = 0, b = 0;
+
+	pool.Spawn(group, [&]() { a = Fibonacci(pool, n - 1); });
+	pool.Spawn(group, [&]() { b = Fibonacci(pool, n - 2); });
+	pool.Sync(group);
+
+	return a + b;
+}
+
+void TestNested()
+{
+	ThreadPool pool(2);
+
+	CHECK(Fibonacci(pool, 24) == 46368);
+}
+
+// タスクの例外は最初の1つをSync()/Wait()で再送出し、他のタスクは最後まで実行する
+void TestException()
+{
+	ThreadPool pool(2);
+	ThreadPool::TaskGroup group;
+	std::atomic<int> count(0);
+
+	for(int i = 0; i < 50; i++)
+	{
+		pool.Spawn(group, [&count, i]() {
+			count++;
+
+			if(i % 10 == 3)
+			{
+				throw std::runtime_error("task");
+			}
+		});
+	}
+
+	bool thrown = false;
+
+	try
+	{
+		pool.Sync(group);
+	}
+	catch(const std::runtime_error &)
+	{
+		thrown = true;
+	}
+
+	CHECK(thrown);
+	CHECK(count == 50);
+
+	thrown = false;
+	pool.Spawn(group, []() { throw std::logic_error("wait"); });
+
+	try
+	{
+		pool.Wait(group);
+	}
+	catch(const std::logic_error &)
+	{
+		thrown = true;
+	}
+
+	CHECK(thrown);
+
+	// 例外は一度だけ再送出する
+	pool.Sync(group);
+}
+
+int main()
+{
+	TestDeque();
+	TestSpawnSync();
+	TestWait();
+	TestStealing();
+	TestNested();
+	TestException();
+
+	return TEST_RESULT();
+}
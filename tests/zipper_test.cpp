@@ -0,0 +1,70 @@
+﻿//
+// zipper_test.cpp
+//
+// Copyright (c) 2024 Izadori
+//
+// This software is released under the MIT License.
+// http://opensource.org/licenses/mit-license.php
+//
+
+#include <list>
+#include <tuple>
+#include <vector>
+
+#include "enumerator.h"
+#include "zipper.h"
+#include "test.h"
+
+//-----------------------------------------------------------------------------------------
+// Slice()・SplitAt()・Split()のテスト
+//-----------------------------------------------------------------------------------------
+
+void TestZipperSlice()
+{
+	std::vector<int> a{0, 1, 2, 3, 4, 5}, b{0, 10, 20, 30, 40};
+	auto zipper = Zip(a, b);
+
+	auto middle = zipper.Slice(1, 3);
+	CHECK(middle.size() == 2 && std::get<1>(middle[0]) == 10);
+
+	// 範囲外はsize()（短い方の列）に、beginはendに切り詰める
+	CHECK(zipper.Slice(2, 100).size() == 3);
+	CHECK(zipper.Slice(100, 200).size() == 0);
+	CHECK(zipper.Slice(4, 2).size() == 0);
+
+	auto [left, right] = zipper.SplitAt(100);
+	CHECK(left.size() == 5 && right.size() == 0);
+
+	size_t total = 0;
+
+	for(auto & part : zipper.Split(4))
+	{
+		total += part.size();
+	}
+
+	CHECK(total == 5);
+}
+
+void TestEnumeratorSlice()
+{
+	std::vector<int> a{0, 1, 2, 3, 4};
+	std::list<int> b{0, 10, 20, 30, 40, 50};
+
+	auto slice = Enumerate(a, 100).Slice(3, 100);
+	CHECK(slice.size() == 2 && std::get<0>(slice[0]) == 103);
+	CHECK(Enumerate(a).Slice(7, 9).size() == 0);
+	CHECK(Enumerate(a).Slice(3, 1).size() == 0);
+
+	auto zipped = Enumerate(Zip(a, b), 0, 2).Slice(4, 10);
+	CHECK(zipped.size() == 1 && std::get<0>(zipped[0]) == 8);
+	CHECK(std::get<1>(std::get<1>(zipped[0])) == 40);
+	CHECK(Enumerate(Zip(a, b)).Slice(10, 20).size() == 0);
+}
+
+int main()
+{
+	TestZipperSlice();
+	TestEnumeratorSlice();
+
+	return TEST_RESULT();
+}
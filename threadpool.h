@@ -0,0 +1,525 @@
+﻿//
+// threadpool.h
+//
+// Copyright (c) 2024 Izadori
+//
+// This software is released under the MIT License.
+// http://opensource.org/licenses/mit-license.php
+//
+
+#ifndef __IZADORI_THREADPOOL_H__
+#define __IZADORI_THREADPOOL_H__
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#elif defined(_WIN32)
+// windows.hのmin/maxマクロがstd::min()/std::max()を壊さないようにする
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#endif
+
+//-----------------------------------------------------------------------------------------
+// ワークスティーリング方式のスレッドプールの実装（C++17対応のコンパイラが必要）
+//-----------------------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------------------
+// WorkStealingDequeクラス - Chase-Levのロックフリーな両端キュー
+//   所有者のスレッドだけがPush()/Take()で末尾を操作し、他のスレッドはSteal()で先頭から取り出す
+//   （Lê, Pop, Cohen, Zappa Nardelli, "Correct and Efficient Work-Stealing for Weak Memory Models"）
+//-----------------------------------------------------------------------------------------
+template <typename T>
+class WorkStealingDeque final
+{
+public:
+	WorkStealingDeque(size_t capacity = 1024) : top_(0), bottom_(0)
+	{
+		buffers_.push_back(std::make_unique<Buffer>(capacity));
+		buffer_.store(buffers_.back().get(), std::memory_order_relaxed);
+	}
+
+	WorkStealingDeque(const WorkStealingDeque &) = delete;
+	WorkStealingDeque & operator=(const WorkStealingDeque &) = delete;
+
+	// 末尾に追加する（所有者のスレッドのみ）
+	void Push(T item)
+	{
+		int64_t bottom = bottom_.load(std::memory_order_relaxed);
+		int64_t top = top_.load(std::memory_order_acquire);
+		Buffer * buffer = buffer_.load(std::memory_order_relaxed);
+
+		if(bottom - top > (int64_t)buffer->size - 1)
+		{
+			buffer = Grow(buffer, top, bottom);
+		}
+
+		buffer->Put(bottom, item);
+		std::atomic_thread_fence(std::memory_order_release);
+		bottom_.store(bottom + 1, std::memory_order_relaxed);
+	}
+
+	// 末尾から取り出す（所有者のスレッドのみ）
+	bool Take(T & item)
+	{
+		int64_t bottom = bottom_.load(std::memory_order_relaxed) - 1;
+		Buffer * buffer = buffer_.load(std::memory_order_relaxed);
+
+		bottom_.store(bottom, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+
+		int64_t top = top_.load(std::memory_order_relaxed);
+
+		if(top > bottom)
+		{
+			bottom_.store(bottom + 1, std::memory_order_relaxed);
+			return false;
+		}
+
+		item = buffer->Get(bottom);
+
+		if(top == bottom)
+		{
+			// 最後の1個は先頭から取り出そうとしているスレッドと競合する
+			bool success = top_.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+			bottom_.store(bottom + 1, std::memory_order_relaxed);
+			return success;
+		}
+
+		return true;
+	}
+
+	// 先頭から取り出す（任意のスレッド）
+	bool Steal(T & item)
+	{
+		int64_t top = top_.load(std::memory_order_acquire);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		int64_t bottom = bottom_.load(std::memory_order_acquire);
+
+		if(top >= bottom)
+		{
+			return false;
+		}
+
+		Buffer * buffer = buffer_.load(std::memory_order_acquire);
+		item = buffer->Get(top);
+
+		return top_.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+	}
+
+private:
+	struct Buffer
+	{
+		size_t size;
+		std::unique_ptr<std::atomic<T>[]> items;
+
+		Buffer(size_t capacity) : size(capacity), items(new std::atomic<T>[capacity]) {}
+
+		T Get(int64_t n) const
+		{
+			return items[(size_t)n & (size - 1)].load(std::memory_order_relaxed);
+		}
+
+		void Put(int64_t n, T item)
+		{
+			items[(size_t)n & (size - 1)].store(item, std::memory_order_relaxed);
+		}
+	};
+
+	alignas(64) std::atomic<int64_t> top_;
+	alignas(64) std::atomic<int64_t> bottom_;
+	std::atomic<Buffer *> buffer_;
+
+	// 拡張前のバッファは他のスレッドが読んでいる可能性があるため、破棄まで保持する
+	std::vector<std::unique_ptr<Buffer>> buffers_;
+
+	Buffer * Grow(Buffer * buffer, int64_t top, int64_t bottom)
+	{
+		buffers_.push_back(std::make_unique<Buffer>(buffer->size * 2));
+		Buffer * grown = buffers_.back().get();
+
+		for(int64_t i = top; i < bottom; i++)
+		{
+			grown->Put(i, buffer->Get(i));
+		}
+
+		buffer_.store(grown, std::memory_order_release);
+		return grown;
+	}
+};
+
+//-----------------------------------------------------------------------------------------
+// ThreadPoolクラス - ワーカーごとのWorkStealingDequeを持つfork-join型のスレッドプール
+//   Spawn()でタスクを追加し、Sync()でTaskGroupの全てのタスクの完了を待つ
+//   Sync()は待つ間も他のタスクを実行するため、並列ループを入れ子にしてもスレッドは増えない
+//-----------------------------------------------------------------------------------------
+class ThreadPool final
+{
+public:
+	//-------------------------------------------------------------------------------------
+	// TaskGroupクラス - Sync()で完了を待つタスクの集まり
+	//-------------------------------------------------------------------------------------
+	class TaskGroup final
+	{
+	public:
+		TaskGroup() : pending_(0) {}
+		TaskGroup(const TaskGroup &) = delete;
+		TaskGroup & operator=(const TaskGroup &) = delete;
+
+	private:
+		std::atomic<size_t> pending_;
+		std::mutex mutex_;
+		std::condition_variable condition_;
+		std::exception_ptr error_;
+
+		friend ThreadPool;
+	};
+
+	// num_threadsはワーカーの数（0の場合はハードウェアのスレッド数 - 1）
+	// pin_threadsがtrueの場合、各ワーカーを別々のCPUに固定する
+	explicit ThreadPool(unsigned int num_threads = 0, bool pin_threads = false)
+		: stop_(false), queued_(0), sleepers_(0)
+	{
+		if(num_threads == 0)
+		{
+			unsigned int hardware = std::thread::hardware_concurrency();
+			num_threads = hardware > 1 ? hardware - 1 : 0;
+		}
+
+		std::vector<int> cpus(num_threads, -1);
+
+		if(pin_threads)
+		{
+			unsigned int hardware = std::thread::hardware_concurrency();
+
+			for(unsigned int i = 0; i < num_threads; i++)
+			{
+				cpus[i] = hardware == 0 ? -1 : (int)(i % hardware);
+			}
+		}
+
+		Start(cpus);
+	}
+
+	// cpusの各CPUに1つずつワーカーを固定して作成する（-1の場合は固定しない）
+	explicit ThreadPool(const std::vector<int> & cpus)
+		: stop_(false), queued_(0), sleepers_(0)
+	{
+		Start(cpus);
+	}
+
+	ThreadPool(const ThreadPool &) = delete;
+	ThreadPool & operator=(const ThreadPool &) = delete;
+
+	~ThreadPool()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			stop_ = true;
+		}
+
+		condition_.notify_all();
+
+		for(auto & worker : workers_)
+		{
+			worker->thread.join();
+		}
+	}
+
+	// ワーカーの数を返す（Sync()を呼び出したスレッドもタスクを実行する）
+	size_t size() const
+	{
+		return workers_.size();
+	}
+
+	// タスクを追加する（ワーカーから呼び出した場合はそのワーカーの両端キューに積む）
+	template <typename Function>
+	void Spawn(TaskGroup & group, Function && func)
+	{
+		Task * task = new Task{std::function<void()>(std::forward<Function>(func)), &group};
+		WorkerContext & context = Current();
+
+		group.pending_.fetch_add(1, std::memory_order_acq_rel);
+
+		if(context.pool == this)
+		{
+			workers_[context.index]->deque.Push(task);
+		}
+		else
+		{
+			std::lock_guard<std::mutex> lock(injection_mutex_);
+			injection_.push_back(task);
+		}
+
+		queued_.fetch_add(1, std::memory_order_seq_cst);
+
+		if(sleepers_.load(std::memory_order_seq_cst) > 0)
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			condition_.notify_one();
+		}
+	}
+
+	// groupの全てのタスクの完了を待つ（待つ間は他のタスクを実行する）
+	// タスクが例外を送出した場合は、最初の例外を再送出する
+	void Sync(TaskGroup & group)
+	{
+		while(group.pending_.load(std::memory_order_acquire) != 0)
+		{
+			Task * task = FindTask();
+
+			if(task != nullptr)
+			{
+				Run(task);
+			}
+			else
+			{
+				std::this_thread::yield();
+			}
+		}
+
+		std::exception_ptr error;
+
+		{
+			std::lock_guard<std::mutex> lock(group.mutex_);
+			std::swap(error, group.error_);
+		}
+
+		if(error)
+		{
+			std::rethrow_exception(error);
+		}
+	}
+
+	// groupの全てのタスクの完了を、タスクを実行せずに待つ
+	//   ワーカーをCPUに固定している場合に、呼び出したスレッドで実行させたくないときに使う
+	//   ワーカーから呼び出した場合やワーカーがない場合は、Sync()と同じく待つ間に他のタスクを実行する
+	void Wait(TaskGroup & group)
+	{
+		if(Current().pool == this || workers_.empty())
+		{
+			Sync(group);
+			return;
+		}
+
+		std::exception_ptr error;
+
+		{
+			std::unique_lock<std::mutex> lock(group.mutex_);
+			group.condition_.wait(lock, [&group]() { return group.pending_.load(std::memory_order_acquire) == 0; });
+			std::swap(error, group.error_);
+		}
+
+		if(error)
+		{
+			std::rethrow_exception(error);
+		}
+	}
+
+	// 既定のスレッドプール（ハードウェアのスレッド数 - 1個のワーカー）を返す
+	static ThreadPool & GetDefault()
+	{
+		static ThreadPool pool;
+		return pool;
+	}
+
+private:
+	struct Task
+	{
+		std::function<void()> func;
+		TaskGroup * group;
+	};
+
+	struct Worker
+	{
+		WorkStealingDeque<Task *> deque;
+		std::thread thread;
+	};
+
+	struct WorkerContext
+	{
+		ThreadPool * pool;
+		size_t index;
+	};
+
+	std::vector<std::unique_ptr<Worker>> workers_;
+	std::mutex injection_mutex_;
+	std::deque<Task *> injection_;
+	std::mutex mutex_;
+	std::condition_variable condition_;
+	bool stop_;
+	std::atomic<size_t> queued_;
+	std::atomic<size_t> sleepers_;
+
+	static WorkerContext & Current()
+	{
+		static thread_local WorkerContext context{nullptr, 0};
+		return context;
+	}
+
+	// 自分の両端キュー、外部から追加されたタスク、他のワーカーの両端キューの順に探す
+	Task * FindTask()
+	{
+		WorkerContext & context = Current();
+		bool is_worker = context.pool == this;
+		Task * task = nullptr;
+
+		if(is_worker && workers_[context.index]->deque.Take(task))
+		{
+			queued_.fetch_sub(1, std::memory_order_relaxed);
+			return task;
+		}
+
+		if(queued_.load(std::memory_order_relaxed) == 0)
+		{
+			return nullptr;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(injection_mutex_);
+
+			if(!injection_.empty())
+			{
+				task = injection_.front();
+				injection_.pop_front();
+				queued_.fetch_sub(1, std::memory_order_relaxed);
+				return task;
+			}
+		}
+
+		size_t count = workers_.size();
+		size_t start = is_worker ? context.index + 1 : 0;
+
+		for(size_t i = 0; i < count; i++)
+		{
+			size_t victim = (start + i) % count;
+
+			if(is_worker && victim == context.index)
+			{
+				continue;
+			}
+
+			if(workers_[victim]->deque.Steal(task))
+			{
+				queued_.fetch_sub(1, std::memory_order_relaxed);
+				return task;
+			}
+		}
+
+		return nullptr;
+	}
+
+	static void Run(Task * task)
+	{
+		TaskGroup * group = task->group;
+
+		try
+		{
+			task->func();
+		}
+		catch(...)
+		{
+			std::lock_guard<std::mutex> lock(group->mutex_);
+
+			if(!group->error_)
+			{
+				group->error_ = std::current_exception();
+			}
+		}
+
+		delete task;
+
+		// 最後のタスクはmutex_を保持したまま完了を通知する（通知後はgroupに触れない）
+		size_t pending = group->pending_.load(std::memory_order_relaxed);
+
+		while(pending > 1 && !group->pending_.compare_exchange_weak(pending, pending - 1, std::memory_order_acq_rel, std::memory_order_relaxed))
+		{
+		}
+
+		if(pending <= 1)
+		{
+			std::lock_guard<std::mutex> lock(group->mutex_);
+			group->pending_.fetch_sub(1, std::memory_order_acq_rel);
+			group->condition_.notify_all();
+		}
+	}
+
+	void Start(const std::vector<int> & cpus)
+	{
+		for(size_t i = 0; i < cpus.size(); i++)
+		{
+			workers_.push_back(std::make_unique<Worker>());
+		}
+
+		for(size_t i = 0; i < cpus.size(); i++)
+		{
+			int cpu = cpus[i];
+			workers_[i]->thread = std::thread([this, i, cpu]() { WorkerLoop(i, cpu); });
+		}
+	}
+
+	static void PinThread(int cpu)
+	{
+#if defined(__linux__)
+		cpu_set_t set;
+		CPU_ZERO(&set);
+		CPU_SET(cpu, &set);
+		pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#elif defined(_WIN32)
+		SetThreadAffinityMask(GetCurrentThread(), DWORD_PTR(1) << cpu);
+#else
+		(void)cpu;
+#endif
+	}
+
+	void WorkerLoop(size_t index, int cpu)
+	{
+		Current() = WorkerContext{this, index};
+
+		if(cpu >= 0)
+		{
+			PinThread(cpu);
+		}
+
+		while(true)
+		{
+			Task * task = FindTask();
+
+			if(task != nullptr)
+			{
+				Run(task);
+				continue;
+			}
+
+			std::unique_lock<std::mutex> lock(mutex_);
+
+			if(stop_)
+			{
+				return;
+			}
+
+			sleepers_.fetch_add(1, std::memory_order_seq_cst);
+			condition_.wait(lock, [this]() { return stop_ || queued_.load(std::memory_order_seq_cst) > 0; });
+			sleepers_.fetch_sub(1, std::memory_order_seq_cst);
+		}
+	}
+};
+
+#endif // __IZADORI_THREADPOOL_H__
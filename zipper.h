@@ -11,9 +11,13 @@
 #define __IZADORI_ZIPPER_H__
 
 #include <algorithm>
+#include <cstddef>
+#include <initializer_list>
+#include <iterator>
 #include <tuple>
 #include <type_traits>
 #include <utility>
+#include <vector>
 
 //-----------------------------------------------------------------------------------------
 // Python風のzip()関数の実装（C++17対応のコンパイラが必要）
@@ -42,6 +46,141 @@ using GetValueType = typename GetIteratorImpl<T>::value_type;
 template <typename T>
 using GetPointer = typename GetIteratorImpl<T>::pointer;
 
+//-----------------------------------------------------------------------------------------
+// IsViewクラス - Zipper<>等が参照ではなく値として保持する軽量な範囲（ビュー）かどうかを判定する
+//-----------------------------------------------------------------------------------------
+template <typename T>
+struct IsView : std::false_type {};
+
+template <typename T>
+using ZipperStorage = std::conditional_t<IsView<T>::value, T, T &>;
+
+//-----------------------------------------------------------------------------------------
+// Subrangeクラス - コンテナの[first, last)の範囲を表すビュー
+//-----------------------------------------------------------------------------------------
+template <class Container>
+class Subrange final
+{
+public:
+	using iterator = GetIterator<Container>;
+
+	Subrange() = delete;
+	Subrange(iterator first, iterator last) : first_(first), last_(last) {}
+
+	iterator begin() const
+	{
+		return first_;
+	}
+
+	iterator end() const
+	{
+		return last_;
+	}
+
+	size_t size() const
+	{
+		return (size_t)std::distance(first_, last_);
+	}
+
+	GetReference<Container> operator[](size_t n) const
+	{
+		return *std::next(first_, n);
+	}
+
+private:
+	iterator first_;
+	iterator last_;
+};
+
+template <class Container>
+struct IsView<Subrange<Container>> : std::true_type {};
+
+// Subrange<>の部分範囲はSubrange<>のままにする
+template <class Container>
+struct SubrangeTypeImpl {
+	using type = Subrange<Container>;
+};
+
+template <class Container>
+struct SubrangeTypeImpl<Subrange<Container>> {
+	using type = Subrange<Container>;
+};
+
+template <class Container>
+using SubrangeType = typename SubrangeTypeImpl<Container>::type;
+
+//-----------------------------------------------------------------------------------------
+// IsRandomAccessクラス - コンテナのイテレータがランダムアクセスイテレータかどうかを判定する
+//-----------------------------------------------------------------------------------------
+template <typename T>
+using IsRandomAccess = std::is_base_of<std::random_access_iterator_tag, typename std::iterator_traits<GetIterator<T>>::iterator_category>;
+
+//-----------------------------------------------------------------------------------------
+// IsMultiPassクラス - コンテナのイテレータが前方向イテレータ以上（複数回走査できる）かどうかを判定する
+//   SpscRingBuffer<>やAsyncFileColumn<>等の入力イテレータの範囲は一度しか読めない
+//-----------------------------------------------------------------------------------------
+template <typename T>
+using IsMultiPass = std::is_base_of<std::forward_iterator_tag, typename std::iterator_traits<GetIterator<T>>::iterator_category>;
+
+//-----------------------------------------------------------------------------------------
+// CommonIteratorCategory - 全てのコンテナのイテレータの種類のうち最も弱いもの
+//-----------------------------------------------------------------------------------------
+template <typename... T>
+using CommonIteratorCategory = std::conditional_t<(IsRandomAccess<T>::value && ...), std::random_access_iterator_tag,
+	std::conditional_t<(IsMultiPass<T>::value && ...), std::forward_iterator_tag, std::input_iterator_tag>>;
+
+template <class... Containers>
+class Zipper;
+
+//-----------------------------------------------------------------------------------------
+// HasSizeクラス - コンテナ（範囲）がsize()で要素数を返せるかどうかを判定する
+//   Zipper<>はsize()を持つが、size()を持たない一度しか読めない列を含む場合は要素数を数えられない
+//-----------------------------------------------------------------------------------------
+template <typename T, typename = void>
+struct HasSizeMember : std::false_type {};
+
+template <typename T>
+struct HasSizeMember<T, std::void_t<decltype(std::declval<T &>().size())>> : std::true_type {};
+
+template <typename T>
+struct HasSize : HasSizeMember<T> {};
+
+// 範囲を読み進めずに要素数を求められるかどうか
+template <typename T>
+using IsCountable = std::bool_constant<HasSize<T>::value || IsMultiPass<T>::value>;
+
+template <class... Containers>
+struct HasSize<Zipper<Containers...>> : std::bool_constant<(IsCountable<Containers>::value && ...)> {};
+
+//-----------------------------------------------------------------------------------------
+// GetRangeSize関数 - コンテナの要素数を返す
+//   size()を持たない場合のみ先頭から数える（一度しか読めない範囲はsize()を持つ必要がある）
+//-----------------------------------------------------------------------------------------
+template <class Container>
+size_t GetRangeSize(Container & container)
+{
+	static_assert(IsCountable<Container>::value, "GetRangeSize cannot count a single-pass range without consuming it");
+
+	if constexpr(HasSize<Container>::value)
+	{
+		return (size_t)container.size();
+	}
+	else
+	{
+		return (size_t)std::distance(std::begin(container), std::end(container));
+	}
+}
+
+//-----------------------------------------------------------------------------------------
+// MakeSubrange関数 - コンテナの[begin, end)番目の要素の範囲を返す（ランダムアクセス可能なコンテナではO(1)）
+//-----------------------------------------------------------------------------------------
+template <class Container>
+SubrangeType<Container> MakeSubrange(Container & container, size_t begin, size_t end)
+{
+	auto first = std::next(std::begin(container), begin);
+	return SubrangeType<Container>(first, std::next(first, end - begin));
+}
+
 //-----------------------------------------------------------------------------------------
 // Zipperコンテナクラス
 //-----------------------------------------------------------------------------------------
@@ -49,6 +188,12 @@ template <class... Containers>
 class Zipper final
 {
 public:
+	// 全てのコンテナがランダムアクセス可能な場合、Iteratorはランダムアクセスイテレータとなり、
+	// end()はbegin()と同じ型を返す（OpenMPのparallel forでrange-based forを並列化できる）
+	// 要素は参照のタプルを値で返すため、std::find_if()等の読み取りのみのアルゴリズムには使えるが、
+	// std::sort()等の要素を入れ替えるアルゴリズムには使えない
+	static constexpr bool random_access = (IsRandomAccess<Containers>::value && ...);
+
 	Zipper() = delete;
 	Zipper(Containers &... containers) : tpl_({containers...}) {}
 
@@ -61,6 +206,12 @@ public:
 	class Iterator final
 	{
 	public:
+		using iterator_category = CommonIteratorCategory<Containers...>;
+		using value_type = std::tuple<GetValueType<Containers>...>;
+		using difference_type = std::ptrdiff_t;
+		using pointer = void;
+		using reference = std::tuple<GetReference<Containers>...>;
+
 		bool operator==(const Iterator & it) const
 		{
 			return this->iter_ == it.iter_;
@@ -87,12 +238,94 @@ public:
 			return *this;
 		}
 
-		auto operator*()
+		Iterator operator++(int)
+		{
+			Iterator it = *this;
+			++*this;
+			return it;
+		}
+
+		auto operator*() const
 		{
 			auto iter_tmp = iter_;
 			return std::apply(GetValue<GetIterator<Containers>...>, iter_tmp);
 		}
 
+		//---------------------------------------------------------------------------------
+		// 以下はランダムアクセス可能なコンテナの場合のみ使用できる
+		//---------------------------------------------------------------------------------
+		Iterator & operator--()
+		{
+			Advance(-1, std::make_index_sequence<sizeof...(Containers)>{});
+			return *this;
+		}
+
+		Iterator operator--(int)
+		{
+			Iterator it = *this;
+			--*this;
+			return it;
+		}
+
+		Iterator & operator+=(difference_type n)
+		{
+			Advance(n, std::make_index_sequence<sizeof...(Containers)>{});
+			return *this;
+		}
+
+		Iterator & operator-=(difference_type n)
+		{
+			return *this += -n;
+		}
+
+		Iterator operator+(difference_type n) const
+		{
+			Iterator it = *this;
+			return it += n;
+		}
+
+		friend Iterator operator+(difference_type n, const Iterator & it)
+		{
+			return it + n;
+		}
+
+		Iterator operator-(difference_type n) const
+		{
+			Iterator it = *this;
+			return it -= n;
+		}
+
+		// 全ての列は同じだけ進むので、先頭の列の差を行数の差とする
+		difference_type operator-(const Iterator & it) const
+		{
+			return std::get<0>(this->iter_) - std::get<0>(it.iter_);
+		}
+
+		auto operator[](difference_type n) const
+		{
+			return *(*this + n);
+		}
+
+		bool operator<(const Iterator & it) const
+		{
+			return std::get<0>(this->iter_) < std::get<0>(it.iter_);
+		}
+
+		bool operator>(const Iterator & it) const
+		{
+			return it < *this;
+		}
+
+		bool operator<=(const Iterator & it) const
+		{
+			return !(it < *this);
+		}
+
+		bool operator>=(const Iterator & it) const
+		{
+			return !(*this < it);
+		}
+
 	private:
 		std::tuple<GetIterator<Containers>...> iter_;
 
@@ -103,8 +336,16 @@ public:
 			(void)swallow{(void(std::get<N>(iter_)++), 0)...};
 		}
 
+		template <size_t... N>
+		void Advance(difference_type n, std::index_sequence<N...>)
+		{
+			using swallow = std::initializer_list<int>;
+			(void)swallow{(void(std::get<N>(iter_) += n), 0)...};
+		}
+
+		// 参照を返すイテレータはその参照を、プロキシ（BitColumn::Reference等）を返すイテレータはその値を返す
 		template <typename ContainerIterator>
-		static auto & GetValueHelper(ContainerIterator & it)
+		static decltype(auto) GetValueHelper(ContainerIterator & it)
 		{
 			return *it;
 		}
@@ -132,9 +373,8 @@ public:
 		template <size_t... N>
 		bool IsEnd(const EndIterator & it, std::index_sequence<N...>) const
 		{
-			bool chk[] = {(std::get<N>(iter_) == std::get<N>(it.iter_))...};
-
-			return std::any_of(std::begin(chk), std::end(chk), [](bool x) { return x; });
+			// 終端に達した列があれば、残りの列は比較しない（SpscRingBuffer<>等は比較で次の要素を待つため）
+			return ((std::get<N>(iter_) == std::get<N>(it.iter_)) || ...);
 		}
 
 		friend Zipper;
@@ -149,9 +389,17 @@ public:
 		return std::apply(Iterator::Begin, tpl_);
 	}
 
-	EndIterator end()
+	// ランダムアクセス可能な場合は最も短い列の長さだけ進めたIteratorを、それ以外はEndIteratorを返す
+	std::conditional_t<random_access, Iterator, EndIterator> end()
 	{
-		return std::apply(Iterator::End, tpl_);
+		if constexpr(random_access)
+		{
+			return begin() + (std::ptrdiff_t)size();
+		}
+		else
+		{
+			return std::apply(Iterator::End, tpl_);
+		}
 	}
 
 	size_t size()
@@ -159,13 +407,73 @@ public:
 		return GetSize(std::make_index_sequence<std::tuple_size<decltype(tpl_)>::value>());
 	}
 
+	// n番目の要素への参照のタプルを返す（ランダムアクセス可能なコンテナではO(1)）
+	std::tuple<GetReference<Containers>...> operator[](size_t n)
+	{
+		static_assert((IsMultiPass<Containers>::value && ...), "Zipper::operator[] cannot index a single-pass range");
+		return GetAt(n, std::make_index_sequence<sizeof...(Containers)>{});
+	}
+
+	// 元のコンテナへの参照のタプルを返す
+	std::tuple<Containers &...> GetContainers()
+	{
+		return std::apply([](Containers &... containers) { return std::tuple<Containers &...>(containers...); }, tpl_);
+	}
+
+	// [begin, end)番目の行だけを参照するZipperを返す（ランダムアクセス可能なコンテナではO(1)）
+	//   endはsize()に、beginはendに切り詰める
+	Zipper<SubrangeType<Containers>...> Slice(size_t begin, size_t end)
+	{
+		size_t n = size();
+		end = end < n ? end : n;
+		begin = begin < end ? begin : end;
+
+		auto subranges = std::apply([begin, end](Containers &... containers) {
+			return std::make_tuple(MakeSubrange(containers, begin, end)...);
+		}, tpl_);
+
+		return std::apply([](SubrangeType<Containers> &... subranges) {
+			return Zipper<SubrangeType<Containers>...>(subranges...);
+		}, subranges);
+	}
+
+	// i番目の行の前後で2つに分割する
+	std::pair<Zipper<SubrangeType<Containers>...>, Zipper<SubrangeType<Containers>...>> SplitAt(size_t i)
+	{
+		size_t n = size();
+		i = i < n ? i : n;
+		return {Slice(0, i), Slice(i, n)};
+	}
+
+	// 互いに重ならない連続したn個の部分に、行数がなるべく均等になるように分割する
+	std::vector<Zipper<SubrangeType<Containers>...>> Split(size_t n)
+	{
+		std::vector<Zipper<SubrangeType<Containers>...>> parts;
+		size_t total = size();
+
+		parts.reserve(n);
+
+		for(size_t i = 0; i < n; i++)
+		{
+			parts.push_back(Slice(total * i / n, total * (i + 1) / n));
+		}
+
+		return parts;
+	}
+
 private:
-	std::tuple<Containers &...> tpl_;
+	std::tuple<ZipperStorage<Containers>...> tpl_;
+
+	template <size_t... N>
+	std::tuple<GetReference<Containers>...> GetAt(size_t n, std::index_sequence<N...>)
+	{
+		return {*std::next(std::begin(std::get<N>(tpl_)), n)...};
+	}
 
 	template <size_t... N>
 	size_t GetSize(std::index_sequence<N...>)
 	{
-		return std::min({(std::distance(std::begin(std::get<N>(tpl_)), std::end(std::get<N>(tpl_))))...});
+		return std::min({GetRangeSize(std::get<N>(tpl_))...});
 	}
 };
 
@@ -178,4 +486,112 @@ auto Zip(Containers &... containers)
 	return Zipper(containers...);
 }
 
+//-----------------------------------------------------------------------------------------
+// IsZipperクラス - Zipper<>かどうかを判定する
+//-----------------------------------------------------------------------------------------
+template <typename T>
+struct IsZipper : std::false_type {};
+
+template <class... Containers>
+struct IsZipper<Zipper<Containers...>> : std::true_type {};
+
+//-----------------------------------------------------------------------------------------
+// HasDataクラス - コンテナが連続したメモリ領域（std::data()）を持つかどうかを判定する
+//-----------------------------------------------------------------------------------------
+template <typename T, typename = void>
+struct HasData : std::false_type {};
+
+template <typename T>
+struct HasData<T, std::void_t<decltype(std::data(std::declval<T &>()))>> : std::true_type {};
+
+//-----------------------------------------------------------------------------------------
+// HasReserveクラス - コンテナがreserve()を持つかどうかを判定する
+//-----------------------------------------------------------------------------------------
+template <typename T, typename = void>
+struct HasReserve : std::false_type {};
+
+template <typename T>
+struct HasReserve<T, std::void_t<decltype(std::declval<T &>().reserve(std::size_t()))>> : std::true_type {};
+
+//-----------------------------------------------------------------------------------------
+// ZipInsertIteratorクラス - タプルを代入すると各要素を対応するコンテナに追加する
+//-----------------------------------------------------------------------------------------
+template <class... Containers>
+class ZipInsertIterator final
+{
+public:
+	using iterator_category = std::output_iterator_tag;
+	using value_type = void;
+	using difference_type = std::ptrdiff_t;
+	using pointer = void;
+	using reference = void;
+
+	ZipInsertIterator() = delete;
+	ZipInsertIterator(Containers &... containers) : tpl_(&containers...) {}
+
+	// 全てのコンテナの容量を一度だけ確保する（reserve()を持たないコンテナは無視する）
+	ZipInsertIterator & Reserve(std::size_t size_hint)
+	{
+		ReserveImpl(size_hint, std::make_index_sequence<sizeof...(Containers)>{});
+		return *this;
+	}
+
+	template <class Tuple, typename = std::enable_if_t<!std::is_same_v<std::decay_t<Tuple>, ZipInsertIterator>>>
+	ZipInsertIterator & operator=(Tuple && values)
+	{
+		PushBack(std::forward<Tuple>(values), std::make_index_sequence<sizeof...(Containers)>{});
+		return *this;
+	}
+
+	ZipInsertIterator & operator*()
+	{
+		return *this;
+	}
+
+	ZipInsertIterator & operator++()
+	{
+		return *this;
+	}
+
+	ZipInsertIterator & operator++(int)
+	{
+		return *this;
+	}
+
+private:
+	std::tuple<Containers *...> tpl_;
+
+	template <size_t... N>
+	void ReserveImpl(std::size_t size_hint, std::index_sequence<N...>)
+	{
+		using swallow = std::initializer_list<int>;
+		(void)swallow{(ReserveHelper(*std::get<N>(tpl_), size_hint), 0)...};
+	}
+
+	template <typename Container>
+	static void ReserveHelper(Container & container, std::size_t size_hint)
+	{
+		if constexpr(HasReserve<Container>::value)
+		{
+			container.reserve(container.size() + size_hint);
+		}
+	}
+
+	template <class Tuple, size_t... N>
+	void PushBack(Tuple && values, std::index_sequence<N...>)
+	{
+		using swallow = std::initializer_list<int>;
+		(void)swallow{(void(std::get<N>(tpl_)->push_back(std::get<N>(std::forward<Tuple>(values)))), 0)...};
+	}
+};
+
+//-----------------------------------------------------------------------------------------
+// ZipInserter関数
+//-----------------------------------------------------------------------------------------
+template <class... Containers>
+auto ZipInserter(Containers &... containers)
+{
+	return ZipInsertIterator<Containers...>(containers...);
+}
+
 #endif // __IZADORI_ZIPPER_H__